@@ -33,6 +33,7 @@
 
 #include "access/htup_details.h"
 #include "access/brin_tuple.h"
+#include "access/toast_compression.h"
 #include "access/tupdesc.h"
 #include "access/tupmacs.h"
 #include "access/tuptoaster.h"
@@ -203,7 +204,8 @@ brin_form_tuple(BrinDesc *brdesc, BlockNumber blkno, BrinMemTuple *tuple,
 				VARSIZE(DatumGetPointer(value)) > TOAST_INDEX_TARGET &&
 				(atttype->typstorage == 'x' || atttype->typstorage == 'm'))
 			{
-				Datum		cvalue = toast_compress_datum(value);
+				Datum		cvalue = toast_compress_datum(value,
+															default_toast_compression);
 
 				if (DatumGetPointer(cvalue) != NULL)
 				{
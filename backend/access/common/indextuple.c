@@ -18,6 +18,7 @@
 
 #include "access/heapam.h"
 #include "access/itup.h"
+#include "access/toast_compression.h"
 #include "access/tuptoaster.h"
 
 
@@ -95,7 +96,8 @@ index_form_tuple(TupleDesc tupleDescriptor,
 			VARSIZE(DatumGetPointer(untoasted_values[i])) > TOAST_INDEX_TARGET &&
 			(att->attstorage == 'x' || att->attstorage == 'm'))
 		{
-			Datum		cvalue = toast_compress_datum(untoasted_values[i]);
+			Datum		cvalue = toast_compress_datum(untoasted_values[i],
+														default_toast_compression);
 
 			if (DatumGetPointer(cvalue) != NULL)
 			{
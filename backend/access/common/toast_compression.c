@@ -0,0 +1,580 @@
+/*-------------------------------------------------------------------------
+ *
+ * toast_compression.c
+ *	  Functions for toast compression.
+ *
+ * Each compression method provides a routine that compresses a plain
+ * varlena into a compressed one, and a routine that turns it back.  The
+ * compress routines only fill in the varlena length word; the caller,
+ * toast_compress_datum(), decides whether the result is worth keeping and
+ * stamps the raw size and method ID into the header.
+ *
+ * Copyright (c) 2000-2018, PostgreSQL Global Development Group
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/access/common/toast_compression.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#ifdef USE_LZ4
+#include <lz4.h>
+#endif
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "access/toast_compression.h"
+#include "common/pg_lzcompress.h"
+#include "utils/guc.h"
+
+/* GUC */
+int			default_toast_compression = TOAST_PGLZ_COMPRESSION_ID;
+
+/*
+ * Only methods supported by this build are listed, so that the GUC and the
+ * per-column option reject the others up front.
+ */
+const struct config_enum_entry default_toast_compression_options[] = {
+	{"pglz", TOAST_PGLZ_COMPRESSION_ID, false},
+#ifdef USE_LZ4
+	{"lz4", TOAST_LZ4_COMPRESSION_ID, false},
+#endif
+#ifdef USE_ZSTD
+	{"zstd", TOAST_ZSTD_COMPRESSION_ID, false},
+#endif
+	{NULL, 0, false}
+};
+
+#define NO_METHOD_SUPPORT(method) \
+	ereport(ERROR, \
+			(errcode(ERRCODE_FEATURE_NOT_SUPPORTED), \
+			 errmsg("compression method %s not supported", method), \
+			 errdetail("This functionality requires the server to be built with %s support.", \
+					   method)))
+
+/*
+ * Compress a varlena using PGLZ.
+ *
+ * Returns the compressed varlena, or NULL if compression fails.
+ */
+struct varlena *
+pglz_compress_datum(const struct varlena *value)
+{
+	int32		valsize,
+				len;
+	struct varlena *tmp = NULL;
+
+	valsize = VARSIZE_ANY_EXHDR(value);
+
+	/*
+	 * No point in wasting a palloc cycle if value size is outside the allowed
+	 * range for compression.
+	 */
+	if (valsize < PGLZ_strategy_default->min_input_size ||
+		valsize > PGLZ_strategy_default->max_input_size)
+		return NULL;
+
+	tmp = (struct varlena *) palloc(PGLZ_MAX_OUTPUT(valsize) +
+									TOAST_COMPRESS_HDRSZ);
+
+	len = pglz_compress(VARDATA_ANY(value),
+						valsize,
+						TOAST_COMPRESS_RAWDATA(tmp),
+						PGLZ_strategy_default);
+	if (len < 0)
+	{
+		pfree(tmp);
+		return NULL;
+	}
+
+	SET_VARSIZE_COMPRESSED(tmp, len + TOAST_COMPRESS_HDRSZ);
+
+	return tmp;
+}
+
+/*
+ * Decode the first rawsize bytes of pglz-compressed data.
+ *
+ * This is pglz_decompress() without its final completeness check: the
+ * input may be cut off anywhere after the point where rawsize bytes of
+ * output have been produced, and decoding simply stops there.  Returns the
+ * number of bytes written to dest (less than rawsize only if the input runs
+ * out first), or -1 if the input is corrupt.
+ */
+static int32
+pglz_decompress_prefix(const char *source, int32 slen, char *dest,
+					   int32 rawsize)
+{
+	const unsigned char *sp;
+	const unsigned char *srcend;
+	unsigned char *dp;
+	unsigned char *destend;
+
+	sp = (const unsigned char *) source;
+	srcend = ((const unsigned char *) source) + slen;
+	dp = (unsigned char *) dest;
+	destend = dp + rawsize;
+
+	while (sp < srcend && dp < destend)
+	{
+		/*
+		 * Read one control byte and process the next 8 items (or as many as
+		 * remain in the compressed input).
+		 */
+		unsigned char ctrl = *sp++;
+		int			ctrlc;
+
+		for (ctrlc = 0; ctrlc < 8 && sp < srcend && dp < destend; ctrlc++)
+		{
+			if (ctrl & 1)
+			{
+				/*
+				 * Set control bit means we must read a match tag.  The match
+				 * is coded with two bytes, plus a third length byte if the
+				 * length nibble is all ones.  A tag cut off by the end of
+				 * the input means we have everything the input can give.
+				 */
+				int32		len;
+				int32		off;
+
+				if (srcend - sp < 2)
+					return (char *) dp - dest;
+				len = (sp[0] & 0x0f) + 3;
+				off = ((sp[0] & 0xf0) << 4) | sp[1];
+				sp += 2;
+				if (len == 18)
+				{
+					if (sp >= srcend)
+						return (char *) dp - dest;
+					len += *sp++;
+				}
+
+				/*
+				 * The offset must point back into what we have already
+				 * written, or the data is corrupt.
+				 */
+				if (off == 0 || off > (char *) dp - dest)
+					return -1;
+
+				/* don't write past the end of the slice */
+				len = Min(len, destend - dp);
+
+				/*
+				 * The match may overlap the bytes it produces, so copy one
+				 * byte at a time, as pglz_decompress() does.
+				 */
+				while (len--)
+				{
+					*dp = dp[-off];
+					dp++;
+				}
+			}
+			else
+			{
+				/* An unset control bit means LITERAL BYTE. */
+				*dp++ = *sp++;
+			}
+
+			/*
+			 * Advance the control bit
+			 */
+			ctrl >>= 1;
+		}
+	}
+
+	return (char *) dp - dest;
+}
+
+/*
+ * Decompress a varlena that was compressed using PGLZ.
+ */
+struct varlena *
+pglz_decompress_datum(const struct varlena *value)
+{
+	struct varlena *result;
+	int32		rawsize;
+
+	/* allocate memory for the uncompressed data */
+	result = (struct varlena *) palloc(TOAST_COMPRESS_RAWSIZE(value) + VARHDRSZ);
+
+	/* decompress the data */
+	rawsize = pglz_decompress(TOAST_COMPRESS_RAWDATA(value),
+							  VARSIZE(value) - TOAST_COMPRESS_HDRSZ,
+							  VARDATA(result),
+							  TOAST_COMPRESS_RAWSIZE(value));
+	if (rawsize < 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_DATA_CORRUPTED),
+				 errmsg_internal("compressed pglz data is corrupt")));
+
+	SET_VARSIZE(result, rawsize + VARHDRSZ);
+
+	return result;
+}
+
+/*
+ * Decompress part of a varlena that was compressed using PGLZ.
+ *
+ * Only the first slicelength bytes of the raw data are produced, and the
+ * input may be just a prefix of the compressed data, as long as it is
+ * at least pglz_maximum_compressed_size() bytes long.
+ */
+struct varlena *
+pglz_decompress_datum_slice(const struct varlena *value, int32 slicelength)
+{
+	struct varlena *result;
+	int32		rawsize;
+
+	/* allocate memory for the uncompressed data */
+	result = (struct varlena *) palloc(slicelength + VARHDRSZ);
+
+	/* decompress the data, stopping once the slice is complete */
+	rawsize = pglz_decompress_prefix(TOAST_COMPRESS_RAWDATA(value),
+									 VARSIZE(value) - TOAST_COMPRESS_HDRSZ,
+									 VARDATA(result),
+									 slicelength);
+	if (rawsize < 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_DATA_CORRUPTED),
+				 errmsg_internal("compressed pglz data is corrupt")));
+
+	SET_VARSIZE(result, rawsize + VARHDRSZ);
+
+	return result;
+}
+
+/*
+ * Upper bound on how many bytes of pglz output are needed to decompress the
+ * first rawsize bytes of the input, capped at the total compressed size.
+ */
+int32
+pglz_maximum_compressed_size(int32 rawsize, int32 total_compressed_size)
+{
+	int64		compressed_size;
+
+	/*
+	 * pglz uses one control bit per byte, so if the entire desired prefix is
+	 * represented as literal bytes, we'll need (rawsize * 9) bits.  Round up
+	 * to whole bytes, and use int64 so this cannot overflow.
+	 */
+	compressed_size = ((int64) rawsize * 9 + 7) / 8;
+
+	/*
+	 * The prefix might end in the middle of a match tag: N-1 or N-2 literal
+	 * bytes followed by a 2 or 3 byte tag.  Allow for the rest of the tag.
+	 */
+	compressed_size += 2;
+
+	/* can't be larger than what there is, which also keeps it within int32 */
+	compressed_size = Min(compressed_size, total_compressed_size);
+
+	return (int32) compressed_size;
+}
+
+/*
+ * Compress a varlena using LZ4.
+ *
+ * Returns the compressed varlena, or NULL if compression fails.
+ */
+struct varlena *
+lz4_compress_datum(const struct varlena *value)
+{
+#ifndef USE_LZ4
+	NO_METHOD_SUPPORT("lz4");
+	return NULL;				/* keep compiler quiet */
+#else
+	int32		valsize;
+	int32		len;
+	int32		max_size;
+	struct varlena *tmp = NULL;
+
+	valsize = VARSIZE_ANY_EXHDR(value);
+
+	/*
+	 * Figure out the maximum possible size of the LZ4 output, add the bytes
+	 * that will be needed for varlena overhead, and allocate that amount.
+	 */
+	max_size = LZ4_compressBound(valsize);
+	tmp = (struct varlena *) palloc(max_size + TOAST_COMPRESS_HDRSZ);
+
+	len = LZ4_compress_default(VARDATA_ANY(value),
+							   TOAST_COMPRESS_RAWDATA(tmp),
+							   valsize, max_size);
+	if (len <= 0)
+		elog(ERROR, "lz4 compression failed");
+
+	/* data is incompressible so just free the memory and return NULL */
+	if (len > valsize)
+	{
+		pfree(tmp);
+		return NULL;
+	}
+
+	SET_VARSIZE_COMPRESSED(tmp, len + TOAST_COMPRESS_HDRSZ);
+
+	return tmp;
+#endif
+}
+
+/*
+ * Decompress a varlena that was compressed using LZ4.
+ */
+struct varlena *
+lz4_decompress_datum(const struct varlena *value)
+{
+#ifndef USE_LZ4
+	NO_METHOD_SUPPORT("lz4");
+	return NULL;				/* keep compiler quiet */
+#else
+	int32		rawsize;
+	struct varlena *result;
+
+	/* allocate memory for the uncompressed data */
+	result = (struct varlena *) palloc(TOAST_COMPRESS_RAWSIZE(value) + VARHDRSZ);
+
+	/* decompress the data */
+	rawsize = LZ4_decompress_safe(TOAST_COMPRESS_RAWDATA(value),
+								  VARDATA(result),
+								  VARSIZE(value) - TOAST_COMPRESS_HDRSZ,
+								  TOAST_COMPRESS_RAWSIZE(value));
+	if (rawsize < 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_DATA_CORRUPTED),
+				 errmsg_internal("compressed lz4 data is corrupt")));
+
+	SET_VARSIZE(result, rawsize + VARHDRSZ);
+
+	return result;
+#endif
+}
+
+/*
+ * Decompress part of a varlena that was compressed using LZ4.
+ */
+struct varlena *
+lz4_decompress_datum_slice(const struct varlena *value, int32 slicelength)
+{
+#ifndef USE_LZ4
+	NO_METHOD_SUPPORT("lz4");
+	return NULL;				/* keep compiler quiet */
+#else
+	int32		rawsize;
+	struct varlena *result;
+
+	/* slice decompression not supported prior to 1.8.3 */
+	if (LZ4_versionNumber() < 10803)
+		return lz4_decompress_datum(value);
+
+	/* allocate memory for the uncompressed data */
+	result = (struct varlena *) palloc(slicelength + VARHDRSZ);
+
+	/* decompress the data */
+	rawsize = LZ4_decompress_safe_partial(TOAST_COMPRESS_RAWDATA(value),
+										  VARDATA(result),
+										  VARSIZE(value) - TOAST_COMPRESS_HDRSZ,
+										  slicelength,
+										  slicelength);
+	if (rawsize < 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_DATA_CORRUPTED),
+				 errmsg_internal("compressed lz4 data is corrupt")));
+
+	SET_VARSIZE(result, rawsize + VARHDRSZ);
+
+	return result;
+#endif
+}
+
+/*
+ * Compress a varlena using zstd.
+ *
+ * Returns the compressed varlena, or NULL if compression fails.
+ */
+struct varlena *
+zstd_compress_datum(const struct varlena *value)
+{
+#ifndef USE_ZSTD
+	NO_METHOD_SUPPORT("zstd");
+	return NULL;				/* keep compiler quiet */
+#else
+	int32		valsize;
+	size_t		len;
+	size_t		max_size;
+	struct varlena *tmp = NULL;
+
+	valsize = VARSIZE_ANY_EXHDR(value);
+
+	max_size = ZSTD_compressBound(valsize);
+	tmp = (struct varlena *) palloc(max_size + TOAST_COMPRESS_HDRSZ);
+
+	len = ZSTD_compress(TOAST_COMPRESS_RAWDATA(tmp), max_size,
+						VARDATA_ANY(value), valsize,
+						ZSTD_CLEVEL_DEFAULT);
+	if (ZSTD_isError(len))
+		elog(ERROR, "zstd compression failed: %s", ZSTD_getErrorName(len));
+
+	/* data is incompressible so just free the memory and return NULL */
+	if (len > (size_t) valsize)
+	{
+		pfree(tmp);
+		return NULL;
+	}
+
+	SET_VARSIZE_COMPRESSED(tmp, len + TOAST_COMPRESS_HDRSZ);
+
+	return tmp;
+#endif
+}
+
+/*
+ * Decompress a varlena that was compressed using zstd.
+ */
+struct varlena *
+zstd_decompress_datum(const struct varlena *value)
+{
+#ifndef USE_ZSTD
+	NO_METHOD_SUPPORT("zstd");
+	return NULL;				/* keep compiler quiet */
+#else
+	size_t		rawsize;
+	struct varlena *result;
+
+	/* allocate memory for the uncompressed data */
+	result = (struct varlena *) palloc(TOAST_COMPRESS_RAWSIZE(value) + VARHDRSZ);
+
+	/* decompress the data */
+	rawsize = ZSTD_decompress(VARDATA(result),
+							  TOAST_COMPRESS_RAWSIZE(value),
+							  TOAST_COMPRESS_RAWDATA(value),
+							  VARSIZE(value) - TOAST_COMPRESS_HDRSZ);
+	if (ZSTD_isError(rawsize))
+		ereport(ERROR,
+				(errcode(ERRCODE_DATA_CORRUPTED),
+				 errmsg_internal("compressed zstd data is corrupt")));
+
+	SET_VARSIZE(result, rawsize + VARHDRSZ);
+
+	return result;
+#endif
+}
+
+/*
+ * Decompress part of a varlena that was compressed using zstd.
+ *
+ * ZSTD_compress() writes a single frame, which we feed through the
+ * streaming decoder with an output buffer of just slicelength bytes;
+ * decoding stops as soon as that buffer is full.
+ */
+struct varlena *
+zstd_decompress_datum_slice(const struct varlena *value, int32 slicelength)
+{
+#ifndef USE_ZSTD
+	NO_METHOD_SUPPORT("zstd");
+	return NULL;				/* keep compiler quiet */
+#else
+	struct varlena *result;
+	ZSTD_DCtx  *dctx;
+	ZSTD_inBuffer in;
+	ZSTD_outBuffer out;
+	size_t		ret = 0;
+
+	/* allocate memory for the uncompressed data */
+	result = (struct varlena *) palloc(slicelength + VARHDRSZ);
+
+	dctx = ZSTD_createDCtx();
+	if (dctx == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_OUT_OF_MEMORY),
+				 errmsg("out of memory")));
+
+	in.src = TOAST_COMPRESS_RAWDATA(value);
+	in.size = VARSIZE(value) - TOAST_COMPRESS_HDRSZ;
+	in.pos = 0;
+	out.dst = VARDATA(result);
+	out.size = slicelength;
+	out.pos = 0;
+
+	while (out.pos < out.size && in.pos < in.size)
+	{
+		ret = ZSTD_decompressStream(dctx, &out, &in);
+		if (ZSTD_isError(ret) || ret == 0)
+			break;
+	}
+	ZSTD_freeDCtx(dctx);
+
+	if (ZSTD_isError(ret))
+		ereport(ERROR,
+				(errcode(ERRCODE_DATA_CORRUPTED),
+				 errmsg_internal("compressed zstd data is corrupt")));
+
+	SET_VARSIZE(result, out.pos + VARHDRSZ);
+
+	return result;
+#endif
+}
+
+/*
+ * Look up a compression method by name.
+ *
+ * Returns TOAST_INVALID_COMPRESSION_ID if the name is unknown or the method
+ * is not supported by this build.
+ */
+ToastCompressionId
+GetToastCompressionId(const char *name)
+{
+	const struct config_enum_entry *entry;
+
+	for (entry = default_toast_compression_options; entry->name; entry++)
+	{
+		if (pg_strcasecmp(name, entry->name) == 0)
+			return (ToastCompressionId) entry->val;
+	}
+
+	return TOAST_INVALID_COMPRESSION_ID;
+}
+
+/*
+ * Get the name of a compression method, for messages.
+ */
+const char *
+GetToastCompressionName(ToastCompressionId cmid)
+{
+	switch (cmid)
+	{
+		case TOAST_PGLZ_COMPRESSION_ID:
+			return "pglz";
+		case TOAST_LZ4_COMPRESSION_ID:
+			return "lz4";
+		case TOAST_ZSTD_COMPRESSION_ID:
+			return "zstd";
+		default:
+			elog(ERROR, "invalid compression method ID %d", (int) cmid);
+	}
+
+	return NULL;				/* keep compiler quiet */
+}
+
+/*
+ * Validator for the "compression" attribute option.
+ */
+void
+validateToastCompressionOption(const char *value)
+{
+	if (value == NULL)
+		return;
+
+	if (GetToastCompressionId(value) == TOAST_INVALID_COMPRESSION_ID)
+	{
+		if (pg_strcasecmp(value, "lz4") == 0)
+			NO_METHOD_SUPPORT("lz4");
+		if (pg_strcasecmp(value, "zstd") == 0)
+			NO_METHOD_SUPPORT("zstd");
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid value for \"compression\" option"),
+				 errdetail("Valid values are \"pglz\", \"lz4\" and \"zstd\".")));
+	}
+}
@@ -3583,6 +3583,9 @@ simple_heap_delete(Relation relation, ItemPointer tid)
  *	wait - true if should wait for any conflicting update to commit/abort
  *	hufd - output parameter, filled in failure cases (see below)
  *	lockmode - output parameter, filled with lock mode acquired on tuple
+ *	summarized_update - output parameter, set true if the update was HOT but
+ *		changed columns covered by summarizing indexes (see below); may be
+ *		NULL
  *
  * Normal, successful return value is HeapTupleMayBeUpdated, which
  * actually means we *did* update it.  Failure return codes are
@@ -3595,6 +3598,14 @@ simple_heap_delete(Relation relation, ItemPointer tid)
  * update was done.  However, any TOAST changes in the new tuple's
  * data are not reflected into *newtup.
  *
+ * Columns covered only by summarizing indexes (e.g. BRIN) do not prevent a
+ * HOT update, because such indexes reference block ranges rather than
+ * individual tuples.  When a HOT update changes one of those columns we set
+ * *summarized_update, and the caller must then insert the new tuple into the
+ * summarizing indexes (and only those).  Callers that pass NULL for
+ * summarized_update are not prepared to do that, so for them such updates
+ * are never done as HOT.
+ *
  * In the failure cases, the routine fills *hufd with the tuple's t_ctid,
  * t_xmax (resolving a possible MultiXact, if necessary), and t_cmax
  * (the last only for HeapTupleSelfUpdated, since we
@@ -3604,12 +3615,14 @@ simple_heap_delete(Relation relation, ItemPointer tid)
 HTSU_Result
 heap_update(Relation relation, ItemPointer otid, HeapTuple newtup,
 			CommandId cid, Snapshot crosscheck, bool wait,
-			HeapUpdateFailureData *hufd, LockTupleMode *lockmode)
+			HeapUpdateFailureData *hufd, LockTupleMode *lockmode,
+			bool *summarized_update)
 {
 	HTSU_Result result;
 	TransactionId xid = GetCurrentTransactionId();
 	Bitmapset  *hot_attrs;
 	Bitmapset  *proj_idx_attrs;
+	Bitmapset  *sum_attrs;
 	Bitmapset  *key_attrs;
 	Bitmapset  *id_attrs;
 	Bitmapset  *interesting_attrs;
@@ -3662,6 +3675,9 @@ heap_update(Relation relation, ItemPointer otid, HeapTuple newtup,
 				(errcode(ERRCODE_INVALID_TRANSACTION_STATE),
 				 errmsg("cannot update tuples during a parallel operation")));
 
+	if (summarized_update)
+		*summarized_update = false;
+
 	/*
 	 * Fetch the list of attributes to be checked for various operations.
 	 *
@@ -3680,6 +3696,8 @@ heap_update(Relation relation, ItemPointer otid, HeapTuple newtup,
 	 */
 	hot_attrs = RelationGetIndexAttrBitmap(relation, INDEX_ATTR_BITMAP_HOT);
 	proj_idx_attrs = RelationGetIndexAttrBitmap(relation, INDEX_ATTR_BITMAP_PROJ);
+	sum_attrs = RelationGetIndexAttrBitmap(relation,
+										   INDEX_ATTR_BITMAP_SUMMARIZED);
 	key_attrs = RelationGetIndexAttrBitmap(relation, INDEX_ATTR_BITMAP_KEY);
 	id_attrs = RelationGetIndexAttrBitmap(relation,
 										  INDEX_ATTR_BITMAP_IDENTITY_KEY);
@@ -3703,6 +3721,7 @@ heap_update(Relation relation, ItemPointer otid, HeapTuple newtup,
 	{
 		interesting_attrs = bms_add_members(interesting_attrs, hot_attrs);
 		interesting_attrs = bms_add_members(interesting_attrs, proj_idx_attrs);
+		interesting_attrs = bms_add_members(interesting_attrs, sum_attrs);
 		hot_attrs_checked = true;
 	}
 	interesting_attrs = bms_add_members(interesting_attrs, key_attrs);
@@ -4016,6 +4035,7 @@ l2:
 			ReleaseBuffer(vmbuffer);
 		bms_free(hot_attrs);
 		bms_free(proj_idx_attrs);
+		bms_free(sum_attrs);
 		bms_free(key_attrs);
 		bms_free(id_attrs);
 		bms_free(modified_attrs);
@@ -4334,6 +4354,28 @@ l2:
 		{
 			use_hot_update = true;
 		}
+
+		/*
+		 * XXX A change to any btree (or other non-summarizing) index column
+		 * still rules out HOT, and the caller then inserts the new tuple
+		 * into every index, even those whose keys are unchanged.  Inserting
+		 * only into the indexes whose keys changed would need index entries
+		 * able to point into the middle of a HOT chain, with a recheck
+		 * against the heap tuple in every index AM, and VACUUM to cope with
+		 * such chains.  None of that exists yet.
+		 */
+
+		/*
+		 * Columns of summarizing indexes don't block HOT, but the caller has
+		 * to know about the change so it can update those indexes.
+		 */
+		if (use_hot_update && bms_overlap(modified_attrs, sum_attrs))
+		{
+			if (summarized_update)
+				*summarized_update = true;
+			else
+				use_hot_update = false;
+		}
 	}
 	else
 	{
@@ -4498,6 +4540,7 @@ l2:
 
 	bms_free(hot_attrs);
 	bms_free(proj_idx_attrs);
+	bms_free(sum_attrs);
 	bms_free(key_attrs);
 	bms_free(id_attrs);
 	bms_free(modified_attrs);
@@ -4751,7 +4794,7 @@ simple_heap_update(Relation relation, ItemPointer otid, HeapTuple tup)
 	result = heap_update(relation, otid, tup,
 						 GetCurrentCommandId(true), InvalidSnapshot,
 						 true /* wait for commit */ ,
-						 &hufd, &lockmode);
+						 &hufd, &lockmode, NULL);
 	switch (result)
 	{
 		case HeapTupleSelfUpdated:
@@ -104,17 +104,18 @@ RelationPutHeapTuple(Relation relation,  // 整张表的关系数据结构
 }
 
 /*
- * Read in a buffer, using bulk-insert strategy if bistate isn't NULL.
+ * Read in a buffer in mode, using bulk-insert strategy if bistate isn't NULL.
  */
 static Buffer
 ReadBufferBI(Relation relation, BlockNumber targetBlock,
-			 BulkInsertState bistate)
+			 ReadBufferMode mode, BulkInsertState bistate)
 {
 	Buffer		buffer;
 
 	/* If not bulk-insert, exactly like ReadBuffer */
 	if (!bistate)
-		return ReadBuffer(relation, targetBlock);//非BulkInsert模式，使用常规方法获取
+		return ReadBufferExtended(relation, MAIN_FORKNUM, targetBlock,
+								  mode, NULL);//非BulkInsert模式，使用常规方法获取
 
     //TODO 以下为BI模式
 	/* If we have the desired block already pinned, re-pin and return it */
@@ -133,7 +134,7 @@ ReadBufferBI(Relation relation, BlockNumber targetBlock,
     //否则根据buffer strategy 重新找一个buffer
 	/* Perform a read using the buffer strategy */
 	buffer = ReadBufferExtended(relation, MAIN_FORKNUM, targetBlock,
-								RBM_NORMAL, bistate->strategy);
+								mode, bistate->strategy);
 
 	/* Save the selected block as target for future inserts */
 	IncrBufferRefCount(buffer);//++buffer的ref_count
@@ -205,14 +206,21 @@ GetVisibilityMapPins(Relation relation, Buffer buffer1, Buffer buffer2,
  * relation extension lock.  Our goal is to pre-extend the relation by an
  * amount which ramps up as the degree of contention ramps up, but limiting
  * the result to some sane overall value.
+ *
+ * The new blocks are added to the file in a single smgrzeroextend() call
+ * and are not read into shared buffers; they stay all-zeroes until some
+ * backend picks one of them from the FSM, at which point
+ * RelationGetBufferForTuple initializes it.  That keeps the time we spend
+ * holding the extension lock short, which is the whole point.
  */
 static void
-RelationAddExtraBlocks(Relation relation, BulkInsertState bistate)
+RelationAddExtraBlocks(Relation relation)
 {
-	BlockNumber blockNum,
-				firstBlock = InvalidBlockNumber;
+	BlockNumber firstBlock,
+				blockNum;
 	int			extraBlocks;
 	int			lockWaiters;
+	Size		freespace;
 
 	/* Use the length of the lock wait queue to judge how much to extend. */
 	lockWaiters = RelationExtensionLockWaiterCount(relation);
@@ -227,54 +235,32 @@ RelationAddExtraBlocks(Relation relation, BulkInsertState bistate)
 	 */
 	extraBlocks = Min(512, lockWaiters * 20);
 
-	do
-	{
-		Buffer		buffer;
-		Page		page;
-		Size		freespace;
-
-		/*
-		 * Extend by one page.  This should generally match the main-line
-		 * extension code in RelationGetBufferForTuple, except that we hold
-		 * the relation extension lock throughout.
-		 */
-		buffer = ReadBufferBI(relation, P_NEW, bistate);
-
-		LockBuffer(buffer, BUFFER_LOCK_EXCLUSIVE);
-		page = BufferGetPage(buffer);
-
-		if (!PageIsNew(page))
-			elog(ERROR, "page %u of relation \"%s\" should be empty but is not",
-				 BufferGetBlockNumber(buffer),
-				 RelationGetRelationName(relation));
-
-		PageInit(page, BufferGetPageSize(buffer), 0);
-
-		/*
-		 * We mark all the new buffers dirty, but do nothing to write them
-		 * out; they'll probably get used soon, and even if they are not, a
-		 * crash will leave an okay all-zeroes page on disk.
-		 */
-		MarkBufferDirty(buffer);
-
-		/* we'll need this info below */
-		blockNum = BufferGetBlockNumber(buffer);
-		freespace = PageGetHeapFreeSpace(page);
-
-		UnlockReleaseBuffer(buffer);
+	/*
+	 * Extend the file in one go.  We hold the relation extension lock, so
+	 * nobody else can be adding blocks concurrently, and a crash will leave
+	 * okay all-zeroes pages on disk.
+	 *
+	 * Since this bypasses shared buffers, bufmgr doesn't get to check for
+	 * leftover buffers of the blocks we're adding, as it does when
+	 * extending with P_NEW; do that here.
+	 */
+	RelationOpenSmgr(relation);
+	firstBlock = smgrnblocks(relation->rd_smgr, MAIN_FORKNUM);
+	CheckBuffersBeyondEOF(relation, MAIN_FORKNUM, firstBlock, extraBlocks);
+	smgrzeroextend(relation->rd_smgr, MAIN_FORKNUM, firstBlock, extraBlocks,
+				   false);
 
-		/* Remember first block number thus added. */
-		if (firstBlock == InvalidBlockNumber)
-			firstBlock = blockNum;
+	/* Free space of an empty heap page, once it has been initialized */
+	freespace = HeapPageEmptyFreeSpace;
 
-		/*
-		 * Immediately update the bottom level of the FSM.  This has a good
-		 * chance of making this page visible to other concurrently inserting
-		 * backends, and we want that to happen without delay.
-		 */
+	/*
+	 * Immediately update the bottom level of the FSM.  This has a good chance
+	 * of making these pages visible to other concurrently inserting backends,
+	 * and we want that to happen without delay.  The FSM is not WAL-logged,
+	 * so this costs no WAL.
+	 */
+	for (blockNum = firstBlock; blockNum < firstBlock + extraBlocks; blockNum++)
 		RecordPageWithFreeSpace(relation, blockNum, freespace);
-	}
-	while (--extraBlocks > 0);
 
 	/*
 	 * Updating the upper levels of the free space map is too expensive to do
@@ -282,7 +268,7 @@ RelationAddExtraBlocks(Relation relation, BulkInsertState bistate)
 	 * subsequent insertion activity sees all of those nifty free pages we
 	 * just inserted.
 	 */
-	FreeSpaceMapVacuumRange(relation, firstBlock, blockNum + 1);
+	FreeSpaceMapVacuumRange(relation, firstBlock, firstBlock + extraBlocks);
 }
 
 /*
@@ -483,7 +469,8 @@ loop:
 		if (otherBuffer == InvalidBuffer)//非Update操作
 		{
 			/* easy case */
-			buffer = ReadBufferBI(relation, targetBlock, bistate);//获取Buffer
+			buffer = ReadBufferBI(relation, targetBlock, RBM_NORMAL,
+								  bistate);//获取Buffer
             // TODO ReadBufferBI() 和 ReadBuffer() 的区别是啥
 			if (PageIsAllVisible(BufferGetPage(buffer)))
                 //如果Page全局可见，那么把Page Pin在内存中（Pin的意思是固定/保留）
@@ -554,6 +541,18 @@ loop:
 		 */
         //从刚才找到的buffer中读出page，BufferGetPage其实是BufferGetBlock的宏，返回void*指针
 		page = BufferGetPage(buffer);
+
+		/*
+		 * Pages added by RelationAddExtraBlocks, or left behind by a backend
+		 * that crashed while extending the relation, are still all-zeroes;
+		 * initialize such a page now, since we're about to use it.
+		 */
+		if (PageIsNew(page))
+		{
+			PageInit(page, BufferGetPageSize(buffer), 0);
+			MarkBufferDirty(buffer);
+		}
+
         //获取页空闲空间，这个函数里page直接强制转换为PageHeader，然后pd_upper-pd_lower算出空闲空间
 		pageFreeSpace = PageGetHeapFreeSpace(page);
 		if (len + saveFreeSpace <= pageFreeSpace)//有足够的空间存储数据，返回此Buffer
@@ -640,7 +639,7 @@ loop:
 			/* Time to bulk-extend. */
             //其它进程没有扩展
             //Just extend it!
-			RelationAddExtraBlocks(relation, bistate);
+			RelationAddExtraBlocks(relation);
 		}
 	}
 
@@ -654,28 +653,13 @@ loop:
 	 * rather than relying on the kernel to do it for us?
 	 */
     //扩展表后，New Page！
-	buffer = ReadBufferBI(relation, P_NEW, bistate);
-
-	/*
-	 * We can be certain that locking the otherBuffer first is OK, since it
-	 * must have a lower page number.
-	 */
-	if (otherBuffer != InvalidBuffer)
-		LockBuffer(otherBuffer, BUFFER_LOCK_EXCLUSIVE);//otherBuffer的顺序一定在扩展的Block之前，Lock it！
-
-	/*
-	 * Now acquire lock on the new page.
-	 */
-	LockBuffer(buffer, BUFFER_LOCK_EXCLUSIVE);//锁定New Page
-
 	/*
-	 * Release the file-extension lock; it's now OK for someone else to extend
-	 * the relation some more.  Note that we cannot release this lock before
-	 * we have buffer lock on the new page, or we risk a race condition
-	 * against vacuumlazy.c --- see comments therein.
+	 * Read the new page already locked.  Pages are initialized lazily, so
+	 * another inserter that found this block through the FSM or as the last
+	 * page of the relation would otherwise be free to initialize it and put
+	 * a tuple on it before we get the lock.
 	 */
-	if (needLock)
-		UnlockRelationForExtension(relation, ExclusiveLock);//释放扩展锁
+	buffer = ReadBufferBI(relation, P_NEW, RBM_ZERO_AND_LOCK, bistate);
 
 	/*
 	 * We need to initialize the empty new page.  Double-check that it really
@@ -690,6 +674,45 @@ loop:
 			 RelationGetRelationName(relation));
     //初始化New Page
 	PageInit(page, BufferGetPageSize(buffer), 0);
+	MarkBufferDirty(buffer);
+
+	/*
+	 * Release the file-extension lock; it's now OK for someone else to extend
+	 * the relation some more.  We hold the lock on the new page, so nobody
+	 * can use it before we're done with it.
+	 */
+	if (needLock)
+		UnlockRelationForExtension(relation, ExclusiveLock);//释放扩展锁
+
+	/*
+	 * Lock the other buffer.  It has a lower page number than the new page,
+	 * so to follow the deadlock-avoidance rule we should have locked it
+	 * first; but doing that would mean holding it locked across the
+	 * extension I/O, or leaving the new page unlocked for a while.  Try a
+	 * conditional lock, which will nearly always succeed.  If it doesn't,
+	 * take the locks in the proper order, and start over if somebody used
+	 * up the new page, or vacuum marked it all-visible, meanwhile.
+	 */
+	if (otherBuffer != InvalidBuffer)
+	{
+		Assert(otherBuffer != buffer);
+
+		if (unlikely(!ConditionalLockBuffer(otherBuffer)))
+		{
+			LockBuffer(buffer, BUFFER_LOCK_UNLOCK);
+			LockBuffer(otherBuffer, BUFFER_LOCK_EXCLUSIVE);
+			LockBuffer(buffer, BUFFER_LOCK_EXCLUSIVE);
+
+			if (len > PageGetHeapFreeSpace(page) || PageIsAllVisible(page))
+			{
+				LockBuffer(otherBuffer, BUFFER_LOCK_UNLOCK);
+				UnlockReleaseBuffer(buffer);
+
+				goto loop;
+			}
+		}
+	}
+
     //New Page也满足不了要求的大小，报错
 	if (len > PageGetHeapFreeSpace(page))
 	{
@@ -22,6 +22,9 @@
  *		heap_tuple_untoast_attr -
  *			Fetch back a given value from the "secondary" relation
  *
+ *		detoast_iterator_begin/next/end -
+ *			Read a value back in pieces, chunk by chunk where possible
+ *
  *-------------------------------------------------------------------------
  */
 
@@ -32,12 +35,14 @@
 
 #include "access/genam.h"
 #include "access/heapam.h"
+#include "access/toast_compression.h"
 #include "access/tuptoaster.h"
 #include "access/xact.h"
 #include "catalog/catalog.h"
 #include "common/int.h"
 #include "common/pg_lzcompress.h"
 #include "miscadmin.h"
+#include "utils/attoptcache.h"
 #include "utils/expandeddatum.h"
 #include "utils/fmgroids.h"
 #include "utils/rel.h"
@@ -49,24 +54,27 @@
 #undef TOAST_DEBUG
 
 /*
- *	The information at the start of the compressed toast data.
+ * State of a detoast iterator.  For an uncompressed external value we keep
+ * an ordered scan open on the toast relation and hand out one chunk per
+ * call; otherwise "value" holds the fully detoasted datum.
  */
-typedef struct toast_compress_header
+typedef struct DetoastIteratorData
 {
-	int32		vl_len_;		/* varlena header (do not touch directly!) */
-	int32		rawsize;
-} toast_compress_header;
+	/* streaming from the toast relation */
+	Relation	toastrel;		/* NULL if not streaming */
+	Relation   *toastidxs;
+	int			num_indexes;
+	SysScanDesc toastscan;
+	SnapshotData SnapshotToast;
+	struct varatt_external toast_pointer;
+	int32		nextidx;		/* next chunk number expected */
+	int32		numchunks;
 
-/*
- * Utilities for manipulation of header information for compressed
- * toast entries.
- */
-#define TOAST_COMPRESS_HDRSZ		((int32) sizeof(toast_compress_header))
-#define TOAST_COMPRESS_RAWSIZE(ptr) (((toast_compress_header *) (ptr))->rawsize)
-#define TOAST_COMPRESS_RAWDATA(ptr) \
-	(((char *) (ptr)) + TOAST_COMPRESS_HDRSZ)
-#define TOAST_COMPRESS_SET_RAWSIZE(ptr, len) \
-	(((toast_compress_header *) (ptr))->rawsize = (len))
+	/* everything else */
+	struct varlena *value;		/* detoasted value, or NULL */
+	bool		free_value;		/* value is ours to pfree */
+	bool		done;			/* value has been returned */
+} DetoastIteratorData;
 
 static void toast_delete_datum(Relation rel, Datum value, bool is_speculative);
 static Datum toast_save_datum(Relation rel, Datum value,
@@ -77,6 +85,9 @@ static struct varlena *toast_fetch_datum(struct varlena *attr);
 static struct varlena *toast_fetch_datum_slice(struct varlena *attr,
 						int32 sliceoffset, int32 length);
 static struct varlena *toast_decompress_datum(struct varlena *attr);
+static struct varlena *toast_decompress_datum_slice(struct varlena *attr,
+							 int32 slicelength);
+static int	toast_get_compression_method(Relation rel, int attnum);
 static int toast_open_indexes(Relation toastrel,
 				   LOCKMODE lock,
 				   Relation **toastidxs,
@@ -290,8 +301,34 @@ heap_tuple_untoast_attr_slice(struct varlena *attr,
 		if (!VARATT_EXTERNAL_IS_COMPRESSED(toast_pointer))
 			return toast_fetch_datum_slice(attr, sliceoffset, slicelength);
 
-		/* fetch it back (compressed marker will get set automatically) */
-		preslice = toast_fetch_datum(attr);
+		/*
+		 * For a compressed datum we only need as much of the compressed data
+		 * as it takes to produce the first slicelimit bytes.  We can't tell
+		 * which method was used before fetching anything, so bound the fetch
+		 * as for pglz, the default; if the value turns out to use another
+		 * method, whose output can't be decoded from a prefix, fetch the rest.
+		 * The fetched chunks include the raw size word, which pglz's bound
+		 * doesn't cover.
+		 */
+		if (slicelimit >= 0)
+		{
+			int32		max_size;
+
+			max_size = pglz_maximum_compressed_size(slicelimit,
+													toast_pointer.va_extsize -
+													(TOAST_COMPRESS_HDRSZ - VARHDRSZ));
+			max_size += TOAST_COMPRESS_HDRSZ - VARHDRSZ;
+
+			preslice = toast_fetch_datum_slice(attr, 0, max_size);
+			if (TOAST_COMPRESS_METHOD(preslice) != TOAST_PGLZ_COMPRESSION_ID &&
+				max_size < toast_pointer.va_extsize)
+			{
+				pfree(preslice);
+				preslice = toast_fetch_datum(attr);
+			}
+		}
+		else
+			preslice = toast_fetch_datum(attr);
 	}
 	else if (VARATT_IS_EXTERNAL_INDIRECT(attr))
 	{
@@ -319,7 +356,11 @@ heap_tuple_untoast_attr_slice(struct varlena *attr,
 	{
 		struct varlena *tmp = preslice;
 
-		preslice = toast_decompress_datum(tmp);
+		/* decompress only the part we need, if we know how much that is */
+		if (slicelimit >= 0)
+			preslice = toast_decompress_datum_slice(tmp, slicelimit);
+		else
+			preslice = toast_decompress_datum(tmp);
 
 		if (tmp != attr)
 			pfree(tmp);
@@ -358,6 +399,192 @@ heap_tuple_untoast_attr_slice(struct varlena *attr,
 }
 
 
+/* ----------
+ * detoast_iterator_begin -
+ *
+ *	Start reading attr piece by piece.  The caller must keep attr, and the
+ *	snapshot it was read under, valid until detoast_iterator_end().
+ * ----------
+ */
+DetoastIterator
+detoast_iterator_begin(struct varlena *attr)
+{
+	DetoastIterator iter = (DetoastIterator) palloc0(sizeof(DetoastIteratorData));
+
+	/* an indirect pointer is just a stand-in for the value it points to */
+	if (VARATT_IS_EXTERNAL_INDIRECT(attr))
+	{
+		struct varatt_indirect redirect;
+
+		VARATT_EXTERNAL_GET_POINTER(redirect, attr);
+		attr = (struct varlena *) redirect.pointer;
+
+		/* nested indirect Datums aren't allowed */
+		Assert(!VARATT_IS_EXTERNAL_INDIRECT(attr));
+	}
+
+	if (VARATT_IS_EXTERNAL_ONDISK(attr))
+	{
+		VARATT_EXTERNAL_GET_POINTER(iter->toast_pointer, attr);
+
+		if (!VARATT_EXTERNAL_IS_COMPRESSED(iter->toast_pointer))
+		{
+			ScanKeyData toastkey;
+			int			validIndex;
+
+			iter->numchunks =
+				((iter->toast_pointer.va_extsize - 1) / TOAST_MAX_CHUNK_SIZE) + 1;
+
+			iter->toastrel = heap_open(iter->toast_pointer.va_toastrelid,
+									   AccessShareLock);
+			validIndex = toast_open_indexes(iter->toastrel,
+											AccessShareLock,
+											&iter->toastidxs,
+											&iter->num_indexes);
+
+			ScanKeyInit(&toastkey,
+						(AttrNumber) 1,
+						BTEqualStrategyNumber, F_OIDEQ,
+						ObjectIdGetDatum(iter->toast_pointer.va_valueid));
+
+			/* the index is on (valueid, chunkidx), so chunks come in order */
+			init_toast_snapshot(&iter->SnapshotToast);
+			iter->toastscan =
+				systable_beginscan_ordered(iter->toastrel,
+										   iter->toastidxs[validIndex],
+										   &iter->SnapshotToast,
+										   1, &toastkey);
+			return iter;
+		}
+	}
+
+	/*
+	 * Compressed, expanded, short or plain.  We have no way to decompress
+	 * incrementally, so get the whole value now.
+	 */
+	if (VARATT_IS_EXTENDED(attr))
+	{
+		iter->value = heap_tuple_untoast_attr(attr);
+		iter->free_value = (iter->value != attr);
+	}
+	else
+		iter->value = attr;
+
+	return iter;
+}
+
+/* ----------
+ * detoast_iterator_next -
+ *
+ *	Return the next piece of the value in *data and *len.  Returns false,
+ *	and leaves the outputs alone, once the whole value has been returned.
+ * ----------
+ */
+bool
+detoast_iterator_next(DetoastIterator iter, const char **data, int32 *len)
+{
+	HeapTuple	ttup;
+	TupleDesc	toasttupDesc;
+	int32		residx;
+	Pointer		chunk;
+	bool		isnull;
+	int32		chunksize;
+	int32		expected;
+
+	if (iter->toastrel == NULL)
+	{
+		if (iter->done)
+			return false;
+		*data = VARDATA_ANY(iter->value);
+		*len = VARSIZE_ANY_EXHDR(iter->value);
+		iter->done = true;
+		return true;
+	}
+
+	if (iter->nextidx >= iter->numchunks)
+		return false;
+
+	ttup = systable_getnext_ordered(iter->toastscan, ForwardScanDirection);
+	if (ttup == NULL)
+		elog(ERROR, "missing chunk number %d for toast value %u in %s",
+			 iter->nextidx,
+			 iter->toast_pointer.va_valueid,
+			 RelationGetRelationName(iter->toastrel));
+
+	toasttupDesc = iter->toastrel->rd_att;
+	residx = DatumGetInt32(fastgetattr(ttup, 2, toasttupDesc, &isnull));
+	Assert(!isnull);
+	chunk = DatumGetPointer(fastgetattr(ttup, 3, toasttupDesc, &isnull));
+	Assert(!isnull);
+	if (!VARATT_IS_EXTENDED(chunk))
+	{
+		chunksize = VARSIZE(chunk) - VARHDRSZ;
+		*data = VARDATA(chunk);
+	}
+	else if (VARATT_IS_SHORT(chunk))
+	{
+		/* could happen due to heap_form_tuple doing its thing */
+		chunksize = VARSIZE_SHORT(chunk) - VARHDRSZ_SHORT;
+		*data = VARDATA_SHORT(chunk);
+	}
+	else
+	{
+		/* should never happen */
+		elog(ERROR, "found toasted toast chunk for toast value %u in %s",
+			 iter->toast_pointer.va_valueid,
+			 RelationGetRelationName(iter->toastrel));
+		chunksize = 0;			/* keep compiler quiet */
+	}
+
+	/*
+	 * Same checks as toast_fetch_datum(): chunks must arrive in order, and
+	 * all but the last must be full.
+	 */
+	if (residx != iter->nextidx)
+		elog(ERROR, "unexpected chunk number %d (expected %d) for toast value %u in %s",
+			 residx, iter->nextidx,
+			 iter->toast_pointer.va_valueid,
+			 RelationGetRelationName(iter->toastrel));
+	if (residx < iter->numchunks - 1)
+		expected = TOAST_MAX_CHUNK_SIZE;
+	else
+		expected = iter->toast_pointer.va_extsize - residx * TOAST_MAX_CHUNK_SIZE;
+	if (chunksize != expected)
+		elog(ERROR, "unexpected chunk size %d (expected %d) in chunk %d of %d for toast value %u in %s",
+			 chunksize, expected,
+			 residx, iter->numchunks,
+			 iter->toast_pointer.va_valueid,
+			 RelationGetRelationName(iter->toastrel));
+
+	*len = chunksize;
+	iter->nextidx++;
+
+	return true;
+}
+
+/* ----------
+ * detoast_iterator_end -
+ *
+ *	Release everything held by the iterator.  It's fine to stop before
+ *	the value has been read to the end.
+ * ----------
+ */
+void
+detoast_iterator_end(DetoastIterator iter)
+{
+	if (iter->toastrel != NULL)
+	{
+		systable_endscan_ordered(iter->toastscan);
+		toast_close_indexes(iter->toastidxs, iter->num_indexes,
+							AccessShareLock);
+		heap_close(iter->toastrel, AccessShareLock);
+	}
+	if (iter->free_value)
+		pfree(iter->value);
+	pfree(iter);
+}
+
+
 /* ----------
  * toast_raw_datum_size -
  *
@@ -789,7 +1016,8 @@ toast_insert_or_update(Relation rel, HeapTuple newtup, HeapTuple oldtup,
 		if (TupleDescAttr(tupleDesc, i)->attstorage == 'x')
 		{
 			old_value = toast_values[i];
-			new_value = toast_compress_datum(old_value);
+			new_value = toast_compress_datum(old_value,
+											 toast_get_compression_method(rel, i + 1));
 
 			if (DatumGetPointer(new_value) != NULL)
 			{
@@ -930,7 +1158,8 @@ toast_insert_or_update(Relation rel, HeapTuple newtup, HeapTuple oldtup,
 		 */
 		i = biggest_attno;
 		old_value = toast_values[i];
-		new_value = toast_compress_datum(old_value);
+		new_value = toast_compress_datum(old_value,
+										 toast_get_compression_method(rel, i + 1));
 
 		if (DatumGetPointer(new_value) != NULL)
 		{
@@ -1373,7 +1602,8 @@ toast_build_flattened_tuple(TupleDesc tupleDesc,
 /* ----------
  * toast_compress_datum -
  *
- *	Create a compressed version of a varlena datum
+ *	Create a compressed version of a varlena datum, using the given
+ *	compression method (a ToastCompressionId)
  *
  *	If we fail (ie, compressed result is actually bigger than original)
  *	then return NULL.  We must not use compressed data if it'd expand
@@ -1384,28 +1614,42 @@ toast_build_flattened_tuple(TupleDesc tupleDesc,
  * ----------
  */
 Datum
-toast_compress_datum(Datum value)
+toast_compress_datum(Datum value, int cmethod)
 {
 	struct varlena *tmp;
 	int32		valsize = VARSIZE_ANY_EXHDR(DatumGetPointer(value));
-	int32		len;
 
 	Assert(!VARATT_IS_EXTERNAL(DatumGetPointer(value)));
 	Assert(!VARATT_IS_COMPRESSED(DatumGetPointer(value)));
 
 	/*
-	 * No point in wasting a palloc cycle if value size is out of the allowed
-	 * range for compression
+	 * Values too small to be worth compressing are skipped up front, whatever
+	 * the method; pglz's lower limit serves for all of them.
 	 */
-	if (valsize < PGLZ_strategy_default->min_input_size ||
-		valsize > PGLZ_strategy_default->max_input_size)
+	if (valsize < PGLZ_strategy_default->min_input_size)
 		return PointerGetDatum(NULL);
 
-	tmp = (struct varlena *) palloc(PGLZ_MAX_OUTPUT(valsize) +
-									TOAST_COMPRESS_HDRSZ);
+	switch ((ToastCompressionId) cmethod)
+	{
+		case TOAST_PGLZ_COMPRESSION_ID:
+			tmp = pglz_compress_datum((const struct varlena *) DatumGetPointer(value));
+			break;
+		case TOAST_LZ4_COMPRESSION_ID:
+			tmp = lz4_compress_datum((const struct varlena *) DatumGetPointer(value));
+			break;
+		case TOAST_ZSTD_COMPRESSION_ID:
+			tmp = zstd_compress_datum((const struct varlena *) DatumGetPointer(value));
+			break;
+		default:
+			elog(ERROR, "invalid compression method %d", cmethod);
+			tmp = NULL;			/* keep compiler quiet */
+	}
+
+	if (tmp == NULL)
+		return PointerGetDatum(NULL);
 
 	/*
-	 * We recheck the actual size even if pglz_compress() reports success,
+	 * We recheck the actual size even if the compressor reports success,
 	 * because it might be satisfied with having saved as little as one byte
 	 * in the compressed data --- which could turn into a net loss once you
 	 * consider header and alignment padding.  Worst case, the compressed
@@ -1414,15 +1658,9 @@ toast_compress_datum(Datum value)
 	 * only one header byte and no padding if the value is short enough.  So
 	 * we insist on a savings of more than 2 bytes to ensure we have a gain.
 	 */
-	len = pglz_compress(VARDATA_ANY(DatumGetPointer(value)),
-						valsize,
-						TOAST_COMPRESS_RAWDATA(tmp),
-						PGLZ_strategy_default);
-	if (len >= 0 &&
-		len + TOAST_COMPRESS_HDRSZ < valsize - 2)
-	{
-		TOAST_COMPRESS_SET_RAWSIZE(tmp, valsize);
-		SET_VARSIZE_COMPRESSED(tmp, len + TOAST_COMPRESS_HDRSZ);
+	if (VARSIZE(tmp) < valsize - 2)
+	{
+		TOAST_COMPRESS_SET_SIZE_AND_METHOD(tmp, valsize, cmethod);
 		/* successful compression */
 		return PointerGetDatum(tmp);
 	}
@@ -1435,6 +1673,43 @@ toast_compress_datum(Datum value)
 }
 
 
+/* ----------
+ * toast_get_compression_method -
+ *
+ *	Choose the compression method for attribute attnum of rel: the column's
+ *	"compression" option if it has one, else default_toast_compression
+ * ----------
+ */
+static int
+toast_get_compression_method(Relation rel, int attnum)
+{
+	AttributeOpts *aopt;
+	int			cmethod = default_toast_compression;
+
+	aopt = get_attribute_options(RelationGetRelid(rel), attnum);
+	if (aopt != NULL)
+	{
+		if (aopt->compression_offset != 0)
+		{
+			ToastCompressionId cmid;
+
+			cmid = GetToastCompressionId((char *) aopt + aopt->compression_offset);
+
+			/*
+			 * The option was validated when it was set, but the server may
+			 * since have been rebuilt without that method.  Rather than fail
+			 * the insert, fall back to the default.
+			 */
+			if (cmid != TOAST_INVALID_COMPRESSION_ID)
+				cmethod = cmid;
+		}
+		pfree(aopt);
+	}
+
+	return cmethod;
+}
+
+
 /* ----------
  * toast_get_valid_index
  *
@@ -2095,10 +2370,11 @@ toast_fetch_datum_slice(struct varlena *attr, int32 sliceoffset, int32 length)
 	VARATT_EXTERNAL_GET_POINTER(toast_pointer, attr);
 
 	/*
-	 * It's nonsense to fetch slices of a compressed datum -- this isn't lo_*
-	 * we can't return a compressed datum which is meaningful to toast later
+	 * It's nonsense to fetch slices of a compressed datum unless starting at
+	 * zero: a prefix of the compressed data can still be decompressed, as
+	 * far as it goes, but nothing else can.
 	 */
-	Assert(!VARATT_EXTERNAL_IS_COMPRESSED(toast_pointer));
+	Assert(!VARATT_EXTERNAL_IS_COMPRESSED(toast_pointer) || sliceoffset == 0);
 
 	attrsize = toast_pointer.va_extsize;
 	totalchunks = ((attrsize - 1) / TOAST_MAX_CHUNK_SIZE) + 1;
@@ -2110,9 +2386,8 @@ toast_fetch_datum_slice(struct varlena *attr, int32 sliceoffset, int32 length)
 	}
 
 	/*
-	 * Adjust length request if needed.  (Note: our sole caller,
-	 * heap_tuple_untoast_attr_slice, protects us against sliceoffset + length
-	 * overflowing.)
+	 * Adjust length request if needed.  (Note: our callers protect us
+	 * against sliceoffset + length overflowing.)
 	 */
 	else if (((sliceoffset + length) > attrsize) || length < 0)
 		length = attrsize - sliceoffset;
@@ -2292,26 +2567,60 @@ toast_fetch_datum_slice(struct varlena *attr, int32 sliceoffset, int32 length)
 /* ----------
  * toast_decompress_datum -
  *
- * Decompress a compressed version of a varlena datum
+ * Decompress a compressed version of a varlena datum, using the method
+ * recorded in its header
  */
 static struct varlena *
 toast_decompress_datum(struct varlena *attr)
 {
-	struct varlena *result;
-
 	Assert(VARATT_IS_COMPRESSED(attr));
 
-	result = (struct varlena *)
-		palloc(TOAST_COMPRESS_RAWSIZE(attr) + VARHDRSZ);
-	SET_VARSIZE(result, TOAST_COMPRESS_RAWSIZE(attr) + VARHDRSZ);
+	switch (TOAST_COMPRESS_METHOD(attr))
+	{
+		case TOAST_PGLZ_COMPRESSION_ID:
+			return pglz_decompress_datum(attr);
+		case TOAST_LZ4_COMPRESSION_ID:
+			return lz4_decompress_datum(attr);
+		case TOAST_ZSTD_COMPRESSION_ID:
+			return zstd_decompress_datum(attr);
+		default:
+			elog(ERROR, "invalid compression method id %d",
+				 (int) TOAST_COMPRESS_METHOD(attr));
+			return NULL;		/* keep compiler quiet */
+	}
+}
 
-	if (pglz_decompress(TOAST_COMPRESS_RAWDATA(attr),
-						VARSIZE(attr) - TOAST_COMPRESS_HDRSZ,
-						VARDATA(result),
-						TOAST_COMPRESS_RAWSIZE(attr)) < 0)
-		elog(ERROR, "compressed data is corrupted");
 
-	return result;
+/* ----------
+ * toast_decompress_datum_slice -
+ *
+ * Decompress the front part of a compressed version of a varlena datum.
+ * The result is at most slicelength bytes of raw data (less if the datum
+ * is shorter).  attr may hold just a prefix of the compressed data; for
+ * pglz it must be at least as long as pglz_maximum_compressed_size() says.
+ */
+static struct varlena *
+toast_decompress_datum_slice(struct varlena *attr, int32 slicelength)
+{
+	Assert(VARATT_IS_COMPRESSED(attr));
+
+	/* no point in stopping early if we want the whole thing anyway */
+	if (slicelength >= TOAST_COMPRESS_RAWSIZE(attr))
+		return toast_decompress_datum(attr);
+
+	switch (TOAST_COMPRESS_METHOD(attr))
+	{
+		case TOAST_PGLZ_COMPRESSION_ID:
+			return pglz_decompress_datum_slice(attr, slicelength);
+		case TOAST_LZ4_COMPRESSION_ID:
+			return lz4_decompress_datum_slice(attr, slicelength);
+		case TOAST_ZSTD_COMPRESSION_ID:
+			return zstd_decompress_datum_slice(attr, slicelength);
+		default:
+			elog(ERROR, "invalid compression method id %d",
+				 (int) TOAST_COMPRESS_METHOD(attr));
+			return NULL;		/* keep compiler quiet */
+	}
 }
 
 
@@ -29,6 +29,12 @@
 /* Minimum tree height for application of fastpath optimization */
 #define BTREE_FASTPATH_MIN_LEVEL	2
 
+/*
+ * Maximum number of duplicates whose heap tuples _bt_kill_dead_duplicates
+ * checks before a page split
+ */
+#define BTREE_MAX_DUPLICATE_CHECKS	64
+
 typedef struct
 {
 	/* context data for _bt_checksplitloc */
@@ -64,7 +70,8 @@ static void _bt_findinsertloc(Relation rel,
 				  ScanKey scankey,
 				  IndexTuple newtup,
 				  BTStack stack,
-				  Relation heapRel);
+				  Relation heapRel,
+				  bool checkingunique);
 static void _bt_insertonpg(Relation rel, Buffer buf, Buffer cbuf,
 			   BTStack stack,
 			   IndexTuple itup,
@@ -86,6 +93,8 @@ static bool _bt_pgaddtup(Page page, Size itemsize, IndexTuple itup,
 static bool _bt_isequal(TupleDesc itupdesc, Page page, OffsetNumber offnum,
 			int keysz, ScanKey scankey);
 static void _bt_vacuum_one_page(Relation rel, Buffer buffer, Relation heapRel);
+static bool _bt_kill_dead_duplicates(Relation rel, Buffer buf, int keysz,
+						 ScanKey scankey, Relation heapRel);
 
 /*
  *	_bt_doinsert() -- Handle insertion of a single index tuple in the tree.
@@ -300,7 +309,7 @@ top:
 		CheckForSerializableConflictIn(rel, NULL, buf);
 		/* do the insertion */
 		_bt_findinsertloc(rel, &buf, &offset, indnkeyatts, itup_scankey, itup,
-						  stack, heapRel);
+						  stack, heapRel, checkUnique != UNIQUE_CHECK_NO);
 		_bt_insertonpg(rel, buf, InvalidBuffer, stack, itup, offset, false);
 	}
 	else
@@ -623,7 +632,13 @@ _bt_check_unique(Relation rel, IndexTuple itup, Relation heapRel,
  *		any existing equal keys because of the way _bt_binsrch() works.
  *
  *		If there's not enough room in the space, we try to make room by
- *		removing any LP_DEAD tuples.
+ *		removing any LP_DEAD tuples.  If that isn't enough and we are about
+ *		to split a leaf page, we also look for existing tuples equal to the
+ *		new key whose heap tuples are dead to everyone, and remove those.
+ *		Such duplicates pile up when rows are updated without HOT, and
+ *		getting rid of them here often saves the split altogether.  This is
+ *		skipped when checkingunique, since _bt_check_unique has already
+ *		marked any such tuples LP_DEAD.
  *
  *		On entry, *bufptr and *offsetptr point to the first legal position
  *		where the new tuple could be inserted.  The caller should hold an
@@ -645,7 +660,8 @@ _bt_findinsertloc(Relation rel,
 				  ScanKey scankey,
 				  IndexTuple newtup,
 				  BTStack stack,
-				  Relation heapRel)
+				  Relation heapRel,
+				  bool checkingunique)
 {
 	Buffer		buf = *bufptr;
 	Page		page = BufferGetPage(buf);
@@ -732,7 +748,19 @@ _bt_findinsertloc(Relation rel,
 		if (P_RIGHTMOST(lpageop) ||
 			_bt_compare(rel, keysz, scankey, page, P_HIKEY) != 0 ||
 			random() <= (MAX_RANDOM_VALUE / 100))
+		{
+			/*
+			 * We're going to split this page.  As a last resort, see if any
+			 * older versions of the new key are dead and can be removed.
+			 */
+			if (P_ISLEAF(lpageop) && !checkingunique &&
+				_bt_kill_dead_duplicates(rel, buf, keysz, scankey, heapRel))
+			{
+				_bt_vacuum_one_page(rel, buf, heapRel);
+				vacuumed = true;
+			}
 			break;
+		}
 
 		/*
 		 * step right to next non-dead page
@@ -2456,3 +2484,64 @@ _bt_vacuum_one_page(Relation rel, Buffer buffer, Relation heapRel)
 	 * the page.
 	 */
 }
+
+/*
+ * _bt_kill_dead_duplicates - mark dead duplicates of the new key LP_DEAD
+ *
+ * Called on a leaf page that is about to be split, with the buffer
+ * exclusive-locked.  The items equal to scankey are checked against the heap,
+ * at most BTREE_MAX_DUPLICATE_CHECKS of them, and those whose HOT chains are
+ * dead to everyone are marked LP_DEAD, the same way _bt_check_unique does.
+ * Returns true if any item was marked, in which case the caller should
+ * remove them with _bt_vacuum_one_page.
+ */
+static bool
+_bt_kill_dead_duplicates(Relation rel, Buffer buf, int keysz,
+						 ScanKey scankey, Relation heapRel)
+{
+	Page		page = BufferGetPage(buf);
+	BTPageOpaque opaque = (BTPageOpaque) PageGetSpecialPointer(page);
+	TupleDesc	itupdesc = RelationGetDescr(rel);
+	SnapshotData SnapshotDirty;
+	OffsetNumber offnum,
+				maxoff;
+	int			nchecked = 0;
+	bool		killed = false;
+
+	InitDirtySnapshot(SnapshotDirty);
+
+	maxoff = PageGetMaxOffsetNumber(page);
+	for (offnum = _bt_binsrch(rel, buf, keysz, scankey, false);
+		 offnum <= maxoff && nchecked < BTREE_MAX_DUPLICATE_CHECKS;
+		 offnum = OffsetNumberNext(offnum))
+	{
+		ItemId		itemid = PageGetItemId(page, offnum);
+		IndexTuple	itup;
+		bool		all_dead;
+
+		if (ItemIdIsDead(itemid))
+			continue;
+
+		if (!_bt_isequal(itupdesc, page, offnum, keysz, scankey))
+			break;				/* past the run of duplicates */
+
+		itup = (IndexTuple) PageGetItem(page, itemid);
+		nchecked++;
+
+		if (!heap_hot_search(&itup->t_tid, heapRel, &SnapshotDirty,
+							 &all_dead) && all_dead)
+		{
+			ItemIdMarkDead(itemid);
+			killed = true;
+		}
+	}
+
+	if (killed)
+	{
+		/* Mark buffer with a dirty hint, since state is not crucial */
+		opaque->btpo_flags |= BTP_HAS_GARBAGE;
+		MarkBufferDirtyHint(buf, true);
+	}
+
+	return killed;
+}
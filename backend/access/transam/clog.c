@@ -80,6 +80,9 @@
  */
 #define THRESHOLD_SUBTRANS_CLOG_OPT	5
 
+/* GUC variable: number of CLOG buffers, 0 means derive from shared_buffers */
+int			transaction_buffers = 0;
+
 /*
  * Link to shared-memory data structures for CLOG control
  */
@@ -677,10 +680,14 @@ TransactionIdGetStatus(TransactionId xid, XLogRecPtr *lsn)
  * configurations.  The following formula seems to represent a reasonable
  * compromise: people with very low values for shared_buffers will get fewer
  * CLOG buffers as well, and everyone else will get 128.
+ *
+ * The transaction_buffers setting overrides this if it's not zero.
  */
 Size
 CLOGShmemBuffers(void)
 {
+	if (transaction_buffers > 0)
+		return transaction_buffers;
 	return Min(128, Max(4, NBuffers / 512));
 }
 
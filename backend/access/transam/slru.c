@@ -81,6 +81,31 @@ typedef struct SlruFlushData
 
 typedef struct SlruFlushData *SlruFlush;
 
+/*
+ * All SLRUs initialized in this process, so that their statistics can be
+ * reported.  SimpleLruInit is run again in each process in EXEC_BACKEND
+ * builds, so this is just process-local state pointing at each subsystem's
+ * static SlruCtlData.
+ */
+#define MAX_REGISTERED_SLRUS	16
+
+static SlruCtl RegisteredSlrus[MAX_REGISTERED_SLRUS];
+static int	NumRegisteredSlrus = 0;
+
+/*
+ * Compute the range of slots [*first, *end) making up the bank that pageno
+ * belongs to.  Banks are spread evenly over the slots, so the bank size is
+ * only approximately SLRU_BANK_SIZE when num_slots isn't a multiple of it.
+ */
+static inline void
+SlruBankRange(SlruShared shared, int pageno, int *first, int *end)
+{
+	int			bankno = (uint32) pageno % shared->num_banks;
+
+	*first = (int) ((int64) bankno * shared->num_slots / shared->num_banks);
+	*end = (int) ((int64) (bankno + 1) * shared->num_slots / shared->num_banks);
+}
+
 /*
  * Macro to mark a buffer slot "most recently used".  Note multiple evaluation
  * of arguments!
@@ -186,6 +211,7 @@ SimpleLruInit(SlruCtl ctl, const char *name, int nslots, int nlsns,
 		shared->ControlLock = ctllock;
 
 		shared->num_slots = nslots;
+		shared->num_banks = Max(1, nslots / SLRU_BANK_SIZE);
 		shared->lsn_groups_per_page = nlsns;
 
 		shared->cur_lru_count = 0;
@@ -232,12 +258,30 @@ SimpleLruInit(SlruCtl ctl, const char *name, int nslots, int nlsns,
 			ptr += BLCKSZ;
 		}
 
+		pg_atomic_init_u64(&shared->stat_blks_zeroed, 0);
+		pg_atomic_init_u64(&shared->stat_blks_hit, 0);
+		pg_atomic_init_u64(&shared->stat_blks_read, 0);
+		pg_atomic_init_u64(&shared->stat_blks_written, 0);
+
 		/* Should fit to estimated shmem size */
 		Assert(ptr - (char *) shared <= SimpleLruShmemSize(nslots, nlsns));
 	}
 	else
 		Assert(found);
 
+	/* Remember this SLRU for statistics reporting (once per process) */
+	{
+		int			i;
+
+		for (i = 0; i < NumRegisteredSlrus; i++)
+		{
+			if (RegisteredSlrus[i] == ctl)
+				break;
+		}
+		if (i == NumRegisteredSlrus && i < MAX_REGISTERED_SLRUS)
+			RegisteredSlrus[NumRegisteredSlrus++] = ctl;
+	}
+
 	/* Register SLRU tranche in the main tranches array */
 	LWLockRegisterTranche(shared->lwlock_tranche_id,
 						  shared->lwlock_tranche_name);
@@ -248,9 +292,45 @@ SimpleLruInit(SlruCtl ctl, const char *name, int nslots, int nlsns,
 	 */
 	ctl->shared = shared;
 	ctl->do_fsync = true;		/* default behavior */
+	ctl->pending_blks_hit = 0;
 	StrNCpy(ctl->Dir, subdir, sizeof(ctl->Dir));
 }
 
+/*
+ * Add this process's pending hit counts to the shared statistics of each
+ * SLRU.  Called from pgstat_report_stat, so that lookups, which are mostly
+ * hits, don't have to touch a shared cache line every time.
+ */
+void
+SimpleLruReportStats(void)
+{
+	int			i;
+
+	for (i = 0; i < NumRegisteredSlrus; i++)
+	{
+		SlruCtl		ctl = RegisteredSlrus[i];
+
+		if (ctl->pending_blks_hit > 0)
+		{
+			pg_atomic_fetch_add_u64(&ctl->shared->stat_blks_hit,
+									ctl->pending_blks_hit);
+			ctl->pending_blks_hit = 0;
+		}
+	}
+}
+
+/*
+ * Return the n'th SLRU initialized in this process, or NULL if there are
+ * fewer than n+1 of them.  Used for statistics reporting.
+ */
+SlruCtl
+SimpleLruGetRegistered(int n)
+{
+	if (n < 0 || n >= NumRegisteredSlrus)
+		return NULL;
+	return RegisteredSlrus[n];
+}
+
 /*
  * Initialize (or reinitialize) a page to zeroes.
  *
@@ -280,6 +360,7 @@ SimpleLruZeroPage(SlruCtl ctl, int pageno)
 
 	/* Set the buffer to zeroes */
 	MemSet(shared->page_buffer[slotno], 0, BLCKSZ);
+	pg_atomic_fetch_add_u64(&shared->stat_blks_zeroed, 1);
 
 	/* Set the LSNs for this new page to zero */
 	SimpleLruZeroLSNs(ctl, slotno);
@@ -404,6 +485,7 @@ SimpleLruReadPage(SlruCtl ctl, int pageno, bool write_ok,
 			}
 			/* Otherwise, it's ready to use */
 			SlruRecentlyUsed(shared, slotno);
+			ctl->pending_blks_hit++;
 			return slotno;
 		}
 
@@ -425,6 +507,7 @@ SimpleLruReadPage(SlruCtl ctl, int pageno, bool write_ok,
 
 		/* Do the read */
 		ok = SlruPhysicalReadPage(ctl, pageno, slotno);
+		pg_atomic_fetch_add_u64(&shared->stat_blks_read, 1);
 
 		/* Set the LSNs for this newly read-in page to zero */
 		SimpleLruZeroLSNs(ctl, slotno);
@@ -468,12 +551,15 @@ SimpleLruReadPage_ReadOnly(SlruCtl ctl, int pageno, TransactionId xid)
 {
 	SlruShared	shared = ctl->shared;
 	int			slotno;
+	int			firstslot;
+	int			endslot;
 
 	/* Try to find the page while holding only shared lock */
 	LWLockAcquire(shared->ControlLock, LW_SHARED);
 
-	/* See if page is already in a buffer */
-	for (slotno = 0; slotno < shared->num_slots; slotno++)
+	/* See if page is already in a buffer; it can only be in its bank */
+	SlruBankRange(shared, pageno, &firstslot, &endslot);
+	for (slotno = firstslot; slotno < endslot; slotno++)
 	{
 		if (shared->page_number[slotno] == pageno &&
 			shared->page_status[slotno] != SLRU_PAGE_EMPTY &&
@@ -481,6 +567,7 @@ SimpleLruReadPage_ReadOnly(SlruCtl ctl, int pageno, TransactionId xid)
 		{
 			/* See comments for SlruRecentlyUsed macro */
 			SlruRecentlyUsed(shared, slotno);
+			ctl->pending_blks_hit++;
 			return slotno;
 		}
 	}
@@ -541,6 +628,7 @@ SlruInternalWritePage(SlruCtl ctl, int slotno, SlruFlush fdata)
 
 	/* Do the write */
 	ok = SlruPhysicalWritePage(ctl, pageno, slotno, fdata);
+	pg_atomic_fetch_add_u64(&shared->stat_blks_written, 1);
 
 	/* If we failed, and we're in a flush, better close the files */
 	if (!ok && fdata)
@@ -960,12 +1048,19 @@ SlruReportIOError(SlruCtl ctl, int pageno, TransactionId xid)
  * (could be any state except EMPTY), *or* a freeable slot (state EMPTY
  * or CLEAN).
  *
+ * Only the bank that pageno maps to is considered, both for the lookup and
+ * for choosing a victim, so the page always ends up in its own bank.
+ *
  * Control lock must be held at entry, and will be held at exit.
  */
 static int
 SlruSelectLRUPage(SlruCtl ctl, int pageno)
 {
 	SlruShared	shared = ctl->shared;
+	int			firstslot;
+	int			endslot;
+
+	SlruBankRange(shared, pageno, &firstslot, &endslot);
 
 	/* Outer loop handles restart after I/O */
 	for (;;)
@@ -980,7 +1075,7 @@ SlruSelectLRUPage(SlruCtl ctl, int pageno)
 		int			best_invalid_page_number = 0;	/* keep compiler quiet */
 
 		/* See if page already has a buffer assigned */
-		for (slotno = 0; slotno < shared->num_slots; slotno++)
+		for (slotno = firstslot; slotno < endslot; slotno++)
 		{
 			if (shared->page_number[slotno] == pageno &&
 				shared->page_status[slotno] != SLRU_PAGE_EMPTY)
@@ -1015,7 +1110,7 @@ SlruSelectLRUPage(SlruCtl ctl, int pageno)
 		 * multiple pages with the same lru_count.
 		 */
 		cur_count = (shared->cur_lru_count)++;
-		for (slotno = 0; slotno < shared->num_slots; slotno++)
+		for (slotno = firstslot; slotno < endslot; slotno++)
 		{
 			int			this_delta;
 			int			this_page_number;
@@ -1065,11 +1160,11 @@ SlruSelectLRUPage(SlruCtl ctl, int pageno)
 		}
 
 		/*
-		 * If all pages (except possibly the latest one) are I/O busy, we'll
-		 * have to wait for an I/O to complete and then retry.  In that
-		 * unhappy case, we choose to wait for the I/O on the least recently
-		 * used slot, on the assumption that it was likely initiated first of
-		 * all the I/Os in progress and may therefore finish first.
+		 * If all pages of the bank (except possibly the latest one) are I/O
+		 * busy, we'll have to wait for an I/O to complete and then retry.
+		 * In that unhappy case, we choose to wait for the I/O on the least
+		 * recently used slot, on the assumption that it was likely initiated
+		 * first of all the I/Os in progress and may therefore finish first.
 		 */
 		if (best_valid_delta < 0)
 		{
@@ -19,6 +19,14 @@
 
 #include "postgres.h"
 
+#ifdef USE_LZ4
+#include <lz4.h>
+#endif
+
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
+
 #include "access/xact.h"
 #include "access/xlog.h"
 #include "access/xlog_internal.h"
@@ -32,9 +40,35 @@
 #include "utils/memutils.h"
 #include "pg_trace.h"
 
-/* Buffer size required to store a compressed version of backup block image */
+/*
+ * Guess the maximum buffer size required to store a compressed version of
+ * backup block image, with any of the supported compression methods.
+ */
 #define PGLZ_MAX_BLCKSZ PGLZ_MAX_OUTPUT(BLCKSZ)
 
+#ifdef USE_LZ4
+#define LZ4_MAX_BLCKSZ		LZ4_COMPRESSBOUND(BLCKSZ)
+#else
+#define LZ4_MAX_BLCKSZ		0
+#endif
+
+#ifdef USE_ZSTD
+#define ZSTD_MAX_BLCKSZ		ZSTD_COMPRESSBOUND(BLCKSZ)
+#else
+#define ZSTD_MAX_BLCKSZ		0
+#endif
+
+#define COMPRESS_BUFSIZE	Max(Max(PGLZ_MAX_BLCKSZ, LZ4_MAX_BLCKSZ), ZSTD_MAX_BLCKSZ)
+
+/*
+ * Range of payload sizes (block data plus main data) of records that we try
+ * to compress with wal_record_compression.  Smaller payloads rarely shrink
+ * enough to pay for the compression header; larger ones usually carry data
+ * that was already compressed, like TOAST chunks.
+ */
+#define XLOG_RECORD_COMPRESS_MIN	128
+#define XLOG_RECORD_COMPRESS_MAX	BLCKSZ	/* COMPRESS_BUFSIZE relies on this */
+
 /*
  * For each block reference registered with XLogRegisterBuffer, we fill in
  * a registered_buffer struct.
@@ -57,7 +91,7 @@ typedef struct
 								 * backup block data in XLogRecordAssemble() */
 
 	/* buffer to store a compressed version of backup block image */
-	char		compressed_page[PGLZ_MAX_BLCKSZ];
+	char		compressed_page[COMPRESS_BUFSIZE];
 } registered_buffer;
 
 static registered_buffer *registered_buffers;
@@ -87,12 +121,22 @@ static uint8 curinsert_flags = 0;
 static XLogRecData hdr_rdt;
 static char *hdr_scratch = NULL;
 
+/*
+ * Working buffers for wal_record_compression: the payload of the record is
+ * gathered into 'record_raw', and compressed into 'record_compressed',
+ * which is then referenced by 'compressed_rdt'.
+ */
+static XLogRecData compressed_rdt;
+static char *record_raw = NULL;
+static char *record_compressed = NULL;
+
 #define SizeOfXlogOrigin	(sizeof(RepOriginId) + sizeof(char))
 
 #define HEADER_SCRATCH_SIZE \
 	(SizeOfXLogRecord + \
 	 MaxSizeOfXLogRecordBlockHeader * (XLR_MAX_BLOCK_ID + 1) + \
-	 SizeOfXLogRecordDataHeaderLong + SizeOfXlogOrigin)
+	 SizeOfXLogRecordDataHeaderLong + SizeOfXlogOrigin + \
+	 SizeOfXLogRecordCompressHeader)
 
 /*
  * An array of XLogRecData structs, to hold registered data.
@@ -111,6 +155,10 @@ static XLogRecData *XLogRecordAssemble(RmgrId rmid, uint8 info,
 				   XLogRecPtr *fpw_lsn);
 static bool XLogCompressBackupBlock(char *page, uint16 hole_offset,
 						uint16 hole_length, char *dest, uint16 *dlen);
+static bool XLogCompressRecordData(XLogRecData *rdata, uint32 len,
+					   uint32 *dlen);
+static int32 XLogCompressData(int method, const char *source, int32 slen,
+				 char *dest);
 
 /*
  * Begin constructing a WAL record. This must be called before the
@@ -492,6 +540,7 @@ XLogRecordAssemble(RmgrId rmid, uint8 info,
 	XLogRecData *rdt_datas_last;
 	XLogRecord *rechdr;
 	char	   *scratch = hdr_scratch;
+	bool		has_image = false;
 
 	/*
 	 * Note: this function can be called multiple times for the same record.
@@ -586,6 +635,8 @@ XLogRecordAssemble(RmgrId rmid, uint8 info,
 			Page		page = regbuf->page;
 			uint16		compressed_len = 0;
 
+			has_image = true;
+
 			/*
 			 * The page needs to be backed up, so calculate its hole length
 			 * and offset.
@@ -620,7 +671,7 @@ XLogRecordAssemble(RmgrId rmid, uint8 info,
 			/*
 			 * Try to compress a block image if wal_compression is enabled
 			 */
-			if (wal_compression)
+			if (wal_compression != WAL_COMPRESSION_NONE)
 			{
 				is_compressed =
 					XLogCompressBackupBlock(page, bimg.hole_offset,
@@ -657,6 +708,12 @@ XLogRecordAssemble(RmgrId rmid, uint8 info,
 				bimg.length = compressed_len;
 				bimg.bimg_info |= BKPIMAGE_IS_COMPRESSED;
 
+				/* pglz is implied by the absence of the other method flags */
+				if (wal_compression == WAL_COMPRESSION_LZ4)
+					bimg.bimg_info |= BKPIMAGE_COMPRESS_LZ4;
+				else if (wal_compression == WAL_COMPRESSION_ZSTD)
+					bimg.bimg_info |= BKPIMAGE_COMPRESS_ZSTD;
+
 				rdt_datas_last->data = regbuf->compressed_page;
 				rdt_datas_last->len = compressed_len;
 			}
@@ -764,6 +821,56 @@ XLogRecordAssemble(RmgrId rmid, uint8 info,
 	rdt_datas_last->next = NULL;
 
 	hdr_rdt.len = (scratch - hdr_scratch);
+
+	/*
+	 * If requested, try to compress the payload of the record (everything
+	 * after the headers) as a whole.  Records carrying full-page images are
+	 * left alone, as the images are much larger than the rest of the record,
+	 * and compressing those is wal_compression's business.  If compression
+	 * succeeds, an XLogRecordCompressHeader is inserted between the fixed
+	 * record header and the block headers, and the payload chain is replaced
+	 * with the compressed copy.
+	 */
+	if (wal_record_compression != WAL_COMPRESSION_NONE && !has_image &&
+		total_len >= XLOG_RECORD_COMPRESS_MIN &&
+		total_len <= XLOG_RECORD_COMPRESS_MAX)
+	{
+		uint32		compressed_len;
+
+		if (XLogCompressRecordData(hdr_rdt.next, total_len, &compressed_len))
+		{
+			uint8		method;
+
+			switch (wal_record_compression)
+			{
+				case WAL_COMPRESSION_LZ4:
+					method = XLR_COMPRESS_LZ4;
+					break;
+				case WAL_COMPRESSION_ZSTD:
+					method = XLR_COMPRESS_ZSTD;
+					break;
+				default:
+					method = XLR_COMPRESS_PGLZ;
+					break;
+			}
+
+			memmove(hdr_scratch + SizeOfXLogRecord + SizeOfXLogRecordCompressHeader,
+					hdr_scratch + SizeOfXLogRecord,
+					hdr_rdt.len - SizeOfXLogRecord);
+			scratch = hdr_scratch + SizeOfXLogRecord;
+			*(scratch++) = (char) XLR_BLOCK_ID_COMPRESSED;
+			*(scratch++) = (char) method;
+			memcpy(scratch, &compressed_len, sizeof(uint32));
+			hdr_rdt.len += SizeOfXLogRecordCompressHeader;
+
+			compressed_rdt.data = record_compressed;
+			compressed_rdt.len = compressed_len;
+			compressed_rdt.next = NULL;
+			hdr_rdt.next = &compressed_rdt;
+			total_len = compressed_len;
+		}
+	}
+
 	total_len += hdr_rdt.len;
 
 	/*
@@ -830,11 +937,11 @@ XLogCompressBackupBlock(char *page, uint16 hole_offset, uint16 hole_length,
 		source = page;
 
 	/*
-	 * We recheck the actual size even if pglz_compress() reports success and
-	 * see if the number of bytes saved by compression is larger than the
-	 * length of extra data needed for the compressed version of block image.
+	 * We recheck the actual size even if compression reports success and see
+	 * if the number of bytes saved by compression is larger than the length
+	 * of extra data needed for the compressed version of block image.
 	 */
-	len = pglz_compress(source, orig_len, dest, PGLZ_strategy_default);
+	len = XLogCompressData(wal_compression, source, orig_len, dest);
 	if (len >= 0 &&
 		len + extra_bytes < orig_len)
 	{
@@ -844,6 +951,95 @@ XLogCompressBackupBlock(char *page, uint16 hole_offset, uint16 hole_length,
 	return false;
 }
 
+/*
+ * Create a compressed version of the payload of a WAL record, i.e. the
+ * concatenation of the given rdata chain, whose total length is 'len'.
+ * The result is stored in record_compressed.
+ *
+ * Returns false if compression fails or doesn't save at least the space of
+ * the compression header. Otherwise, returns true and sets 'dlen' to the
+ * length of the compressed data.
+ */
+static bool
+XLogCompressRecordData(XLogRecData *rdata, uint32 len, uint32 *dlen)
+{
+	char	   *dest = record_raw;
+	int32		clen;
+
+	Assert(len <= XLOG_RECORD_COMPRESS_MAX);
+
+	/* compression needs contiguous input, so gather the chain first */
+	for (; rdata != NULL; rdata = rdata->next)
+	{
+		memcpy(dest, rdata->data, rdata->len);
+		dest += rdata->len;
+	}
+	Assert(dest - record_raw == len);
+
+	clen = XLogCompressData(wal_record_compression, record_raw, len,
+							record_compressed);
+	if (clen >= 0 &&
+		clen + SizeOfXLogRecordCompressHeader < len)
+	{
+		*dlen = (uint32) clen;
+		return true;
+	}
+	return false;
+}
+
+/*
+ * Compress 'slen' bytes at 'source' into 'dest' with the given WalCompression
+ * method.  'slen' must not exceed BLCKSZ, and 'dest' must have room for
+ * COMPRESS_BUFSIZE bytes.
+ *
+ * Returns the length of the compressed data, or -1 if the data could not be
+ * compressed.
+ */
+static int32
+XLogCompressData(int method, const char *source, int32 slen, char *dest)
+{
+	int32		len = -1;
+
+	Assert(slen <= BLCKSZ);
+
+	switch (method)
+	{
+		case WAL_COMPRESSION_PGLZ:
+			len = pglz_compress(source, slen, dest, PGLZ_strategy_default);
+			break;
+
+		case WAL_COMPRESSION_LZ4:
+#ifdef USE_LZ4
+			len = LZ4_compress_default(source, dest, slen, COMPRESS_BUFSIZE);
+			if (len <= 0)
+				len = -1;		/* failure */
+#else
+			elog(ERROR, "LZ4 is not supported by this build");
+#endif
+			break;
+
+		case WAL_COMPRESSION_ZSTD:
+#ifdef USE_ZSTD
+			{
+				size_t		zlen;
+
+				zlen = ZSTD_compress(dest, COMPRESS_BUFSIZE, source, slen,
+									 ZSTD_CLEVEL_DEFAULT);
+				len = ZSTD_isError(zlen) ? -1 : (int32) zlen;
+			}
+#else
+			elog(ERROR, "zstd is not supported by this build");
+#endif
+			break;
+
+		default:
+			elog(ERROR, "unrecognized WAL compression method: %d", method);
+			break;
+	}
+
+	return len;
+}
+
 /*
  * Determine whether the buffer referenced has to be backed up.
  *
@@ -1147,4 +1343,17 @@ InitXLogInsert(void)
 	if (hdr_scratch == NULL)
 		hdr_scratch = MemoryContextAllocZero(xloginsert_cxt,
 											 HEADER_SCRATCH_SIZE);
+
+	/*
+	 * And buffers for compressing record payloads.  These are needed inside
+	 * critical sections, so allocate them up front, even though they may
+	 * never be used.
+	 */
+	if (record_raw == NULL)
+	{
+		record_raw = MemoryContextAlloc(xloginsert_cxt,
+										XLOG_RECORD_COMPRESS_MAX);
+		record_compressed = MemoryContextAlloc(xloginsert_cxt,
+											   COMPRESS_BUFSIZE);
+	}
 }
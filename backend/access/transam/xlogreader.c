@@ -17,6 +17,14 @@
  */
 #include "postgres.h"
 
+#ifdef USE_LZ4
+#include <lz4.h>
+#endif
+
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
+
 #include "access/transam.h"
 #include "access/xlogrecord.h"
 #include "access/xlog_internal.h"
@@ -30,6 +38,9 @@
 #endif
 
 static bool allocate_recordbuf(XLogReaderState *state, uint32 reclength);
+static bool XLogCompressMethodSupported(uint8 method);
+static bool XLogDecompressData(uint8 method, const char *source, int32 slen,
+				   char *dest, int32 rawsize);
 
 static bool ValidXLogRecordHeader(XLogReaderState *state, XLogRecPtr RecPtr,
 					  XLogRecPtr PrevRecPtr, XLogRecord *record, bool randAccess);
@@ -137,6 +148,8 @@ XLogReaderFree(XLogReaderState *state)
 	}
 	if (state->main_data)
 		pfree(state->main_data);
+	if (state->decompressed_data)
+		pfree(state->decompressed_data);
 
 	pfree(state->errormsg_buf);
 	if (state->readRecordBuf)
@@ -1095,6 +1108,9 @@ DecodeXLogRecord(XLogReaderState *state, XLogRecord *record, char **errormsg)
 	uint32		datatotal;
 	RelFileNode *rnode = NULL;
 	uint8		block_id;
+	bool		compressed = false;
+	uint8		compress_method = 0;
+	uint32		compressed_len = 0;
 
 	ResetDecoder(state);
 
@@ -1105,9 +1121,22 @@ DecodeXLogRecord(XLogReaderState *state, XLogRecord *record, char **errormsg)
 	ptr += SizeOfXLogRecord;
 	remaining = record->xl_tot_len - SizeOfXLogRecord;
 
+	/*
+	 * If the payload of the record is compressed, the compression header
+	 * comes first.  It tells us how many bytes of the record are payload, so
+	 * that we know where the remaining headers end.
+	 */
+	if (remaining > 0 && (uint8) *ptr == XLR_BLOCK_ID_COMPRESSED)
+	{
+		COPY_HEADER_FIELD(&block_id, sizeof(uint8));
+		COPY_HEADER_FIELD(&compress_method, sizeof(uint8));
+		COPY_HEADER_FIELD(&compressed_len, sizeof(uint32));
+		compressed = true;
+	}
+
 	/* Decode the headers */
 	datatotal = 0;
-	while (remaining > datatotal)
+	while (remaining > (compressed ? compressed_len : datatotal))
 	{
 		COPY_HEADER_FIELD(&block_id, sizeof(uint8));
 
@@ -1295,6 +1324,44 @@ DecodeXLogRecord(XLogReaderState *state, XLogRecord *record, char **errormsg)
 		}
 	}
 
+	if (compressed)
+	{
+		if (remaining != compressed_len)
+			goto shortdata_err;
+
+		if (!XLogCompressMethodSupported(compress_method))
+		{
+			report_invalid_record(state,
+								  "could not decompress record at %X/%X compressed with unsupported method %u",
+								  (uint32) (state->ReadRecPtr >> 32),
+								  (uint32) state->ReadRecPtr,
+								  (unsigned int) compress_method);
+			goto err;
+		}
+
+		if (!state->decompressed_data || datatotal > state->decompressed_bufsz)
+		{
+			if (state->decompressed_data)
+				pfree(state->decompressed_data);
+			state->decompressed_bufsz = MAXALIGN(Max(datatotal, BLCKSZ));
+			state->decompressed_data = palloc(state->decompressed_bufsz);
+		}
+
+		if (!XLogDecompressData(compress_method, ptr, compressed_len,
+								state->decompressed_data, datatotal))
+		{
+			report_invalid_record(state,
+								  "invalid compressed record data at %X/%X",
+								  (uint32) (state->ReadRecPtr >> 32),
+								  (uint32) state->ReadRecPtr);
+			goto err;
+		}
+
+		/* continue with the decompressed copy of the payload */
+		ptr = state->decompressed_data;
+		remaining = datatotal;
+	}
+
 	if (remaining != datatotal)
 		goto shortdata_err;
 
@@ -1461,9 +1528,30 @@ RestoreBlockImage(XLogReaderState *record, uint8 block_id, char *page)
 
 	if (bkpb->bimg_info & BKPIMAGE_IS_COMPRESSED)
 	{
+		uint8		method;
+
+		if ((bkpb->bimg_info & BKPIMAGE_COMPRESS_LZ4) &&
+			(bkpb->bimg_info & BKPIMAGE_COMPRESS_ZSTD))
+			method = 0;			/* invalid */
+		else if (bkpb->bimg_info & BKPIMAGE_COMPRESS_LZ4)
+			method = XLR_COMPRESS_LZ4;
+		else if (bkpb->bimg_info & BKPIMAGE_COMPRESS_ZSTD)
+			method = XLR_COMPRESS_ZSTD;
+		else
+			method = XLR_COMPRESS_PGLZ;
+
+		if (!XLogCompressMethodSupported(method))
+		{
+			report_invalid_record(record, "could not restore image at %X/%X compressed with unsupported method, block %d",
+								  (uint32) (record->ReadRecPtr >> 32),
+								  (uint32) record->ReadRecPtr,
+								  block_id);
+			return false;
+		}
+
 		/* If a backup block image is compressed, decompress it */
-		if (pglz_decompress(ptr, bkpb->bimg_len, tmp.data,
-							BLCKSZ - bkpb->hole_length) < 0)
+		if (!XLogDecompressData(method, ptr, bkpb->bimg_len, tmp.data,
+								BLCKSZ - bkpb->hole_length))
 		{
 			report_invalid_record(record, "invalid compressed image at %X/%X, block %d",
 								  (uint32) (record->ReadRecPtr >> 32),
@@ -1491,3 +1579,65 @@ RestoreBlockImage(XLogReaderState *record, uint8 block_id, char *page)
 
 	return true;
 }
+
+/*
+ * Is the given XLR_COMPRESS_* method supported by this build?
+ */
+static bool
+XLogCompressMethodSupported(uint8 method)
+{
+	switch (method)
+	{
+		case XLR_COMPRESS_PGLZ:
+			return true;
+		case XLR_COMPRESS_LZ4:
+#ifdef USE_LZ4
+			return true;
+#else
+			return false;
+#endif
+		case XLR_COMPRESS_ZSTD:
+#ifdef USE_ZSTD
+			return true;
+#else
+			return false;
+#endif
+		default:
+			return false;
+	}
+}
+
+/*
+ * Decompress 'slen' bytes of data compressed with the given XLR_COMPRESS_*
+ * method into 'dest', which must have room for 'rawsize' bytes.
+ *
+ * Returns true only if the data decompressed to exactly 'rawsize' bytes.
+ */
+static bool
+XLogDecompressData(uint8 method, const char *source, int32 slen,
+				   char *dest, int32 rawsize)
+{
+	switch (method)
+	{
+		case XLR_COMPRESS_PGLZ:
+			return pglz_decompress(source, slen, dest, rawsize) == rawsize;
+
+#ifdef USE_LZ4
+		case XLR_COMPRESS_LZ4:
+			return LZ4_decompress_safe(source, dest, slen, rawsize) == rawsize;
+#endif
+
+#ifdef USE_ZSTD
+		case XLR_COMPRESS_ZSTD:
+			{
+				size_t		len;
+
+				len = ZSTD_decompress(dest, rawsize, source, slen);
+				return !ZSTD_isError(len) && len == (size_t) rawsize;
+			}
+#endif
+
+		default:
+			return false;
+	}
+}
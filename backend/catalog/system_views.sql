@@ -885,6 +885,26 @@ CREATE VIEW pg_stat_bgwriter AS
         pg_stat_get_buf_alloc() AS buffers_alloc,
         pg_stat_get_bgwriter_stat_reset_time() AS stats_reset;
 
+CREATE VIEW pg_stat_lwlocks AS
+    SELECT
+        s.tranche_id,
+        s.tranche,
+        s.acquisitions,
+        s.blocks,
+        s.wait_time,
+        s.spin_delays
+    FROM pg_stat_get_lwlocks() s;
+
+CREATE VIEW pg_stat_slru AS
+    SELECT
+        s.name,
+        s.buffers,
+        s.blks_zeroed,
+        s.blks_hit,
+        s.blks_read,
+        s.blks_written
+    FROM pg_stat_get_slru() s;
+
 CREATE VIEW pg_stat_progress_vacuum AS
 	SELECT
 		S.pid AS pid, S.datid AS datid, D.datname AS datname,
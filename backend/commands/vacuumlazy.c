@@ -4,23 +4,41 @@
  *	  Concurrent ("lazy") vacuuming.
  *
  *
- * The major space usage for LAZY VACUUM is storage for the array of dead tuple
+ * The major space usage for LAZY VACUUM is storage for the set of dead tuple
  * TIDs.  We want to ensure we can vacuum even the very largest relations with
- * finite memory space usage.  To do that, we set upper bounds on the number of
- * tuples we will keep track of at once.
+ * finite memory space usage.  To do that, we set upper bounds on the amount of
+ * dead tuple information we will keep track of at once.
  *
  * We are willing to use at most maintenance_work_mem (or perhaps
  * autovacuum_work_mem) memory space to keep track of dead tuples.  We
- * initially allocate an array of TIDs of that size, with an upper limit that
- * depends on table size (this limit ensures we don't allocate a huge area
- * uselessly for vacuuming small tables).  If the array threatens to overflow,
- * we suspend the heap scan phase and perform a pass of index cleanup and page
- * compaction, then resume the heap scan with an empty TID array.
+ * initially allocate a dead tuple store (see LVDeadTuples) of that size, with
+ * an upper limit that depends on table size (this limit ensures we don't
+ * allocate a huge area uselessly for vacuuming small tables).  If the store
+ * threatens to overflow, we suspend the heap scan phase and perform a pass of
+ * index cleanup and page compaction, then resume the heap scan with an empty
+ * store.
+ *
+ * The store keeps one small entry per heap page with dead tuples, and the
+ * page's dead offsets either inline in the entry, as a sorted list, or as a
+ * bitmap, whichever is smallest.  A page full of dead tuples thus takes a few
+ * dozen bytes rather than six bytes per TID, so most vacuums need only one
+ * index pass, and checking an index entry's TID costs a binary search over
+ * pages rather than over TIDs.
  *
  * If we're processing a table with no indexes, we can just vacuum each page
  * as we go; there's no need to save up multiple tuples to minimize the number
  * of index scans performed.  So we don't use maintenance_work_mem memory for
- * the TID array, just enough to hold as many heap tuples as fit on one page.
+ * the dead tuple store, just enough to hold the dead tuples of one page.
+ *
+ * When the table has more than one index, index vacuuming and cleanup can be
+ * spread over parallel workers (up to max_parallel_maintenance_workers).  In
+ * that case the dead tuple store is allocated in a DSM segment, so that the
+ * workers can see it, and each index pass launches a fresh set of workers
+ * that grab indexes one at a time from a shared counter; the leader takes
+ * part as well.
+ * Bulk-delete results are kept in shared memory between passes, and the
+ * leader updates pg_class for the indexes once parallel mode has been left,
+ * since catalog updates are not allowed in parallel mode.
  *
  *
  * Portions Copyright (c) 1996-2018, PostgreSQL Global Development Group
@@ -41,20 +59,25 @@
 #include "access/heapam_xlog.h"
 #include "access/htup_details.h"
 #include "access/multixact.h"
+#include "access/parallel.h"
 #include "access/transam.h"
 #include "access/visibilitymap.h"
 #include "access/xlog.h"
+#include "catalog/pg_am.h"
 #include "catalog/storage.h"
 #include "commands/dbcommands.h"
 #include "commands/progress.h"
 #include "commands/vacuum.h"
 #include "miscadmin.h"
+#include "optimizer/paths.h"
 #include "pgstat.h"
+#include "port/atomics.h"
 #include "portability/instr_time.h"
 #include "postmaster/autovacuum.h"
 #include "storage/bufmgr.h"
 #include "storage/freespace.h"
 #include "storage/lmgr.h"
+#include "tcop/tcopprot.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "utils/pg_rusage.h"
@@ -93,11 +116,59 @@
 	((BlockNumber) (((uint64) 8 * 1024 * 1024 * 1024) / BLCKSZ))
 
 /*
- * Guesstimation of number of dead tuples per page.  This is used to
- * provide an upper limit to memory allocated when vacuuming small
- * tables.
+ * Dead tuple storage.  An LVDeadTuples is one chunk of memory, allocated
+ * locally or, for parallel vacuum, in the DSM segment.  items[] holds an array
+ * of LVDeadBlock entries growing up from the start, one per heap block with
+ * dead tuples, in block number order; the payloads of the entries grow down
+ * from the end.  Everything is counted in uint16 units.
+ *
+ * The data word of an entry holds the format in its top two bits.  For
+ * DEADBLOCK_INLINE, the low 30 bits hold up to two offset numbers, 15 bits
+ * each (an unused slot is InvalidOffsetNumber).  For the other formats the low
+ * 30 bits are the items[] index of the payload, whose first word is a count:
+ * for DEADBLOCK_LIST the number of sorted offset numbers that follow, for
+ * DEADBLOCK_BITMAP the number of bitmap words that follow, in which bit
+ * (off % 16) of word (off / 16) is set for each dead offset.
+ */
+typedef struct LVDeadBlock
+{
+	BlockNumber blkno;
+	uint32		data;
+} LVDeadBlock;
+
+typedef struct LVDeadTuples
+{
+	int			max_items;		/* size of items[] */
+	int			num_tuples;		/* # of dead tuple TIDs stored */
+	int			num_blocks;		/* # of LVDeadBlock entries */
+	int			payload_start;	/* items[] index of the lowest payload */
+	uint16		items[FLEXIBLE_ARRAY_MEMBER];
+} LVDeadTuples;
+
+#define DEADBLOCK_INLINE		0
+#define DEADBLOCK_LIST			1
+#define DEADBLOCK_BITMAP		2
+
+#define DEADBLOCK_FORMAT(data)		((data) >> 30)
+#define DEADBLOCK_PAYLOAD(data)		((data) & 0x3FFFFFFF)
+#define DEADBLOCK_INLINE_OFFSET(data, n) \
+	((OffsetNumber) (((data) >> ((n) * 15)) & 0x7FFF))
+#define DEADBLOCK_MAKE(format, payload) \
+	(((uint32) (format) << 30) | (uint32) (payload))
+
+#define LVDeadBlocks(dt)		((LVDeadBlock *) (dt)->items)
+
+/* Space one LVDeadBlock entry takes in items[] */
+#define DEADBLOCK_ITEMS			(sizeof(LVDeadBlock) / sizeof(uint16))
+
+/*
+ * Worst-case items[] space taken by the dead tuples of one heap page: an
+ * entry, plus a payload no bigger than a bitmap covering every possible
+ * offset.  This is also used to limit the memory allocated when vacuuming
+ * small tables.
  */
-#define LAZY_ALLOC_TUPLES		MaxHeapTuplesPerPage
+#define DEAD_TUPLES_PAGE_ITEMS \
+	(DEADBLOCK_ITEMS + 1 + MaxHeapTuplesPerPage / 16 + 1)
 
 /*
  * Before we consider skipping a page that's marked as clean in
@@ -111,6 +182,22 @@
  */
 #define PREFETCH_SIZE			((BlockNumber) 32)
 
+/*
+ * Index vacuuming is skipped when the dead tuples found in a single heap
+ * pass are all LP_DEAD stubs, and are on fewer than this fraction of the
+ * table's pages.  See lazy_scan_heap.
+ */
+#define BYPASS_THRESHOLD_PAGES	0.02
+
+/*
+ * DSM keys for parallel index vacuuming.  Unlike other parallel execution
+ * code, since we don't need to worry about DSM keys conflicting with
+ * plan_node_id we can use small integers.
+ */
+#define PARALLEL_VACUUM_KEY_SHARED			1
+#define PARALLEL_VACUUM_KEY_DEAD_TUPLES		2
+#define PARALLEL_VACUUM_KEY_QUERY_TEXT		3
+
 typedef struct LVRelStats
 {
 	/* hasindex = true means two-pass strategy; false means one-pass */
@@ -121,6 +208,8 @@ typedef struct LVRelStats
 	BlockNumber scanned_pages;	/* number of pages we examined */
 	BlockNumber pinskipped_pages;	/* # of pages we skipped due to a pin */
 	BlockNumber frozenskipped_pages;	/* # of frozen pages we skipped */
+	BlockNumber frozen_pages;	/* # of pages we froze tuples on */
+	BlockNumber eager_frozen_pages; /* # of those frozen before FreezeLimit */
 	BlockNumber tupcount_pages; /* pages whose tuples we counted */
 	double		old_live_tuples;	/* previous value of pg_class.reltuples */
 	double		new_rel_tuples; /* new estimated total # of tuples */
@@ -129,16 +218,57 @@ typedef struct LVRelStats
 	BlockNumber pages_removed;
 	double		tuples_deleted;
 	BlockNumber nonempty_pages; /* actually, last nonempty page + 1 */
-	/* List of TIDs of tuples we intend to delete */
-	/* NB: this list is ordered by TID address */
-	int			num_dead_tuples;	/* current # of entries */
-	int			max_dead_tuples;	/* # slots allocated in array */
-	ItemPointer dead_tuples;	/* array of ItemPointerData */
+	/* TIDs of tuples we intend to delete */
+	LVDeadTuples *dead_tuples;
 	int			num_index_scans;
 	TransactionId latestRemovedXid;
 	bool		lock_waiter_detected;
 } LVRelStats;
 
+/*
+ * Per-index state shared with parallel vacuum workers.  The bulk-delete
+ * result of an index lives here between passes, so that whichever process
+ * picks up the index next can continue from it.
+ */
+typedef struct LVSharedIndStats
+{
+	bool		parallel_safe;	/* can a worker process this index? */
+	bool		updated;		/* is stats valid? */
+	IndexBulkDeleteResult stats;
+} LVSharedIndStats;
+
+/*
+ * State shared between the leader and parallel vacuum workers, stored in the
+ * DSM segment under PARALLEL_VACUUM_KEY_SHARED.  The leader fills in the
+ * copies of its LVRelStats fields before each pass.
+ */
+typedef struct LVShared
+{
+	Oid			relid;			/* heap relation being vacuumed */
+	int			elevel;			/* message level for index reports */
+	int			nindexes;		/* # of entries in indstats[] */
+	bool		for_cleanup;	/* amvacuumcleanup rather than ambulkdelete? */
+
+	/* Copies of the LVRelStats fields the index routines look at */
+	double		old_live_tuples;
+	double		new_rel_tuples;
+	BlockNumber rel_pages;
+	BlockNumber tupcount_pages;
+
+	/* Next index to be processed by some participant */
+	pg_atomic_uint32 nextindex;
+
+	LVSharedIndStats indstats[FLEXIBLE_ARRAY_MEMBER];
+} LVShared;
+
+/* Leader-local state for parallel index vacuuming */
+typedef struct LVParallelState
+{
+	ParallelContext *pcxt;
+	LVShared   *lvshared;
+	int			nlaunches;		/* # of index passes run so far */
+} LVParallelState;
+
 
 /* A few variables that don't seem worth passing around as parameters */
 static int	elevel = -1;
@@ -156,23 +286,55 @@ static void lazy_scan_heap(Relation onerel, int options,
 			   bool aggressive);
 static void lazy_vacuum_heap(Relation onerel, LVRelStats *vacrelstats);
 static bool lazy_check_needs_freeze(Buffer buf, bool *hastup);
+static int lazy_prepare_eager_freeze(Page page, TransactionId relfrozenxid,
+						  MultiXactId relminmxid,
+						  xl_heap_freeze_tuple *frozen);
+static void lazy_vacuum_all_indexes(Relation *Irel,
+						IndexBulkDeleteResult **stats,
+						LVRelStats *vacrelstats, LVParallelState *lps,
+						int nindexes);
+static void lazy_cleanup_all_indexes(Relation *Irel,
+						 IndexBulkDeleteResult **stats,
+						 LVRelStats *vacrelstats, LVParallelState *lps,
+						 int nindexes);
 static void lazy_vacuum_index(Relation indrel,
 				  IndexBulkDeleteResult **stats,
 				  LVRelStats *vacrelstats);
 static void lazy_cleanup_index(Relation indrel,
-				   IndexBulkDeleteResult *stats,
+				   IndexBulkDeleteResult **stats,
 				   LVRelStats *vacrelstats);
+static void update_index_statistics(Relation *Irel,
+						IndexBulkDeleteResult **stats, int nindexes);
+static LVParallelState *begin_parallel_vacuum(Relation onerel, Relation *Irel,
+					  int nindexes, LVRelStats *vacrelstats,
+					  BlockNumber nblocks);
+static void end_parallel_vacuum(LVParallelState *lps,
+					LVRelStats *vacrelstats);
+static int compute_parallel_vacuum_workers(Relation onerel, Relation *Irel,
+								int nindexes, bool *can_parallel);
+static void lazy_parallel_process_indexes(Relation *Irel,
+							  IndexBulkDeleteResult **stats,
+							  LVRelStats *vacrelstats, LVParallelState *lps,
+							  int nindexes, bool for_cleanup);
+static void parallel_vacuum_index_loop(Relation *Irel, LVShared *lvshared,
+						   LVRelStats *vacrelstats);
 static int lazy_vacuum_page(Relation onerel, BlockNumber blkno, Buffer buffer,
-				 int tupindex, LVRelStats *vacrelstats, Buffer *vmbuffer);
+				 int blockidx, LVRelStats *vacrelstats, Buffer *vmbuffer);
 static bool should_attempt_truncation(LVRelStats *vacrelstats);
 static void lazy_truncate_heap(Relation onerel, LVRelStats *vacrelstats);
 static BlockNumber count_nondeletable_pages(Relation onerel,
 						 LVRelStats *vacrelstats);
+static Size compute_dead_tuples_space(BlockNumber relblocks, bool hasindex);
+static void dead_tuples_init(LVDeadTuples *dt, Size size);
+static void dead_tuples_reset(LVDeadTuples *dt);
+static bool dead_tuples_has_room_for_page(LVDeadTuples *dt);
+static int dead_tuples_get_offsets(LVDeadTuples *dt, int blockidx,
+						OffsetNumber *offsets);
 static void lazy_space_alloc(LVRelStats *vacrelstats, BlockNumber relblocks);
-static void lazy_record_dead_tuple(LVRelStats *vacrelstats,
-					   ItemPointer itemptr);
+static void lazy_record_dead_tuples(LVRelStats *vacrelstats,
+						BlockNumber blkno, OffsetNumber *offsets,
+						int noffsets);
 static bool lazy_tid_reaped(ItemPointer itemptr, void *state);
-static int	vac_cmp_itemptr(const void *left, const void *right);
 static bool heap_page_is_all_visible(Relation rel, Buffer buf,
 						 TransactionId *visibility_cutoff_xid, bool *all_frozen);
 
@@ -388,6 +550,9 @@ lazy_vacuum_rel(Relation onerel, int options, VacuumParams *params,
 							 vacrelstats->rel_pages,
 							 vacrelstats->pinskipped_pages,
 							 vacrelstats->frozenskipped_pages);
+			appendStringInfo(&buf, _("frozen: %u pages had tuples frozen, %u of them eagerly\n"),
+							 vacrelstats->frozen_pages,
+							 vacrelstats->eager_frozen_pages);
 			appendStringInfo(&buf,
 							 _("tuples: %.0f removed, %.0f remain, %.0f are dead but not yet removable, oldest xmin: %u\n"),
 							 vacrelstats->tuples_deleted,
@@ -478,12 +643,15 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 				nkeep,			/* dead-but-not-removable tuples */
 				nunused;		/* unused item pointers */
 	IndexBulkDeleteResult **indstats;
+	LVParallelState *lps = NULL;
+	bool		have_tupgone = false;
 	int			i;
 	PGRUsage	ru0;
 	Buffer		vmbuffer = InvalidBuffer;
 	BlockNumber next_unskippable_block;
 	bool		skipping_blocks;
 	xl_heap_freeze_tuple *frozen;
+	xl_heap_freeze_tuple *eager_frozen;
 	StringInfoData buf;
 	const int	initprog_index[] = {
 		PROGRESS_VACUUM_PHASE,
@@ -520,13 +688,23 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 	vacrelstats->nonempty_pages = 0;
 	vacrelstats->latestRemovedXid = InvalidTransactionId;
 
-	lazy_space_alloc(vacrelstats, nblocks);
+	/*
+	 * Try to set up parallel index vacuuming; if that's not possible or not
+	 * worthwhile, allocate the dead tuple store locally.
+	 */
+	if (vacrelstats->hasindex)
+		lps = begin_parallel_vacuum(onerel, Irel, nindexes, vacrelstats,
+									nblocks);
+	if (lps == NULL)
+		lazy_space_alloc(vacrelstats, nblocks);
 	frozen = palloc(sizeof(xl_heap_freeze_tuple) * MaxHeapTuplesPerPage);
+	eager_frozen = palloc(sizeof(xl_heap_freeze_tuple) * MaxHeapTuplesPerPage);
 
 	/* Report that we're scanning the heap, advertising total # of blocks */
 	initprog_val[0] = PROGRESS_VACUUM_PHASE_SCAN_HEAP;
 	initprog_val[1] = nblocks;
-	initprog_val[2] = vacrelstats->max_dead_tuples;
+	/* Report the number of TIDs that are sure to fit, one per page */
+	initprog_val[2] = vacrelstats->dead_tuples->max_items / DEADBLOCK_ITEMS;
 	pgstat_progress_update_multi_param(3, initprog_index, initprog_val);
 
 	/*
@@ -611,7 +789,11 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 		bool		tupgone,
 					hastup;
 		int			prev_dead_count;
+		OffsetNumber deadoffsets[MaxHeapTuplesPerPage];
+		int			ndeadoffsets;
+		int			npruned;
 		int			nfrozen;
+		TransactionId freeze_cutoff;
 		Size		freespace;
 		bool		all_visible_according_to_vm = false;
 		bool		all_visible;
@@ -704,8 +886,8 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 		 * If we are close to overrunning the available space for dead-tuple
 		 * TIDs, pause and do a cycle of vacuuming before we tackle this page.
 		 */
-		if ((vacrelstats->max_dead_tuples - vacrelstats->num_dead_tuples) < MaxHeapTuplesPerPage &&
-			vacrelstats->num_dead_tuples > 0)
+		if (!dead_tuples_has_room_for_page(vacrelstats->dead_tuples) &&
+			vacrelstats->dead_tuples->num_tuples > 0)
 		{
 			const int	hvp_index[] = {
 				PROGRESS_VACUUM_PHASE,
@@ -733,10 +915,8 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 										 PROGRESS_VACUUM_PHASE_VACUUM_INDEX);
 
 			/* Remove index entries */
-			for (i = 0; i < nindexes; i++)
-				lazy_vacuum_index(Irel[i],
-								  &indstats[i],
-								  vacrelstats);
+			lazy_vacuum_all_indexes(Irel, indstats, vacrelstats, lps,
+									nindexes);
 
 			/*
 			 * Report that we are now vacuuming the heap.  We also increase
@@ -756,7 +936,7 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 			 * not to reset latestRemovedXid since we want that value to be
 			 * valid.
 			 */
-			vacrelstats->num_dead_tuples = 0;
+			dead_tuples_reset(vacrelstats->dead_tuples);
 			vacrelstats->num_index_scans++;
 
 			/*
@@ -852,42 +1032,26 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 		if (PageIsNew(page))
 		{
 			/*
-			 * An all-zeroes page could be left over if a backend extends the
-			 * relation but crashes before initializing the page. Reclaim such
-			 * pages for use.
+			 * All-zeroes pages can be left over if a backend extends the
+			 * relation but crashes before initializing the page, and they
+			 * are created routinely when RelationAddExtraBlocks bulk-extends
+			 * the relation; it enters them into the FSM and leaves them for
+			 * RelationGetBufferForTuple to initialize on first use.
 			 *
-			 * We have to be careful here because we could be looking at a
-			 * page that someone has just added to the relation and not yet
-			 * been able to initialize (see RelationGetBufferForTuple). To
-			 * protect against that, release the buffer lock, grab the
-			 * relation extension lock momentarily, and re-lock the buffer. If
-			 * the page is still uninitialized by then, it must be left over
-			 * from a crashed backend, and we can initialize it.
-			 *
-			 * We don't really need the relation lock when this is a new or
-			 * temp relation, but it's probably not worth the code space to
-			 * check that, since this surely isn't a critical path.
-			 *
-			 * Note: the comparable code in vacuum.c need not worry because
-			 * it's got exclusive lock on the whole relation.
+			 * So there's nothing to fix here.  We don't initialize the page
+			 * ourselves, since that would dirty it without WAL-logging just to
+			 * save the next inserter some work, and we don't mark it
+			 * all-visible for the same reason.  Just make sure the FSM knows
+			 * about the page, in case that was lost in a crash.
 			 */
-			LockBuffer(buf, BUFFER_LOCK_UNLOCK);
-			LockRelationForExtension(onerel, ExclusiveLock);
-			UnlockRelationForExtension(onerel, ExclusiveLock);
-			LockBufferForCleanup(buf);
-			if (PageIsNew(page))
-			{
-				ereport(WARNING,
-						(errmsg("relation \"%s\" page %u is uninitialized --- fixing",
-								relname, blkno)));
-				PageInit(page, BufferGetPageSize(buf), 0);
-				empty_pages++;
-			}
-			freespace = PageGetHeapFreeSpace(page);
-			MarkBufferDirty(buf);
 			UnlockReleaseBuffer(buf);
+			empty_pages++;
 
-			RecordPageWithFreeSpace(onerel, blkno, freespace);
+			if (GetRecordedFreeSpace(onerel, blkno) == 0)
+			{
+				freespace = HeapPageEmptyFreeSpace;
+				RecordPageWithFreeSpace(onerel, blkno, freespace);
+			}
 			continue;
 		}
 
@@ -935,8 +1099,9 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 		 *
 		 * We count tuples removed by the pruning step as removed by VACUUM.
 		 */
-		tups_vacuumed += heap_page_prune(onerel, buf, OldestXmin, false,
-										 &vacrelstats->latestRemovedXid);
+		npruned = heap_page_prune(onerel, buf, OldestXmin, false,
+								  &vacrelstats->latestRemovedXid);
+		tups_vacuumed += npruned;
 
 		/*
 		 * Now scan the page to collect vacuumable items and check for tuples
@@ -946,7 +1111,8 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 		has_dead_tuples = false;
 		nfrozen = 0;
 		hastup = false;
-		prev_dead_count = vacrelstats->num_dead_tuples;
+		prev_dead_count = vacrelstats->dead_tuples->num_tuples;
+		ndeadoffsets = 0;
 		maxoff = PageGetMaxOffsetNumber(page);
 
 		/*
@@ -985,7 +1151,7 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 			 */
 			if (ItemIdIsDead(itemid))
 			{
-				lazy_record_dead_tuple(vacrelstats, &(tuple.t_self));
+				deadoffsets[ndeadoffsets++] = offnum;
 				all_visible = false;
 				continue;
 			}
@@ -1131,11 +1297,12 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 
 			if (tupgone)
 			{
-				lazy_record_dead_tuple(vacrelstats, &(tuple.t_self));
+				deadoffsets[ndeadoffsets++] = offnum;
 				HeapTupleHeaderAdvanceLatestRemovedXid(tuple.t_data,
 													   &vacrelstats->latestRemovedXid);
 				tups_vacuumed += 1;
 				has_dead_tuples = true;
+				have_tupgone = true;
 			}
 			else
 			{
@@ -1160,6 +1327,40 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 			}
 		}						/* scan along page */
 
+		/* Remember the page's dead tuples, if any */
+		lazy_record_dead_tuples(vacrelstats, blkno, deadoffsets, ndeadoffsets);
+
+		/*
+		 * If the page is all-visible, but freezing what's older than
+		 * FreezeLimit won't make it all-frozen, consider freezing all of its
+		 * tuples right away.  Otherwise an aggressive vacuum would have to
+		 * come back and rewrite the page later, which for append-mostly
+		 * tables means rewriting most of the table.  We only do this when
+		 * the page is going to be dirtied and WAL-logged anyway: because we
+		 * are about to set it all-visible, because it was pruned, or because
+		 * we're freezing some of its tuples regardless.
+		 */
+		freeze_cutoff = FreezeLimit;
+		if (vacuum_eager_freeze && all_visible && !all_frozen &&
+			(!all_visible_according_to_vm || npruned > 0 || nfrozen > 0))
+		{
+			int			neager;
+
+			neager = lazy_prepare_eager_freeze(page, relfrozenxid, relminmxid,
+											   eager_frozen);
+			if (neager >= 0)
+			{
+				memcpy(frozen, eager_frozen,
+					   neager * sizeof(xl_heap_freeze_tuple));
+				nfrozen = neager;
+				all_frozen = true;
+				/* standby queries may not see what we're now freezing */
+				freeze_cutoff = OldestXmin;
+				if (nfrozen > 0)
+					vacrelstats->eager_frozen_pages++;
+			}
+		}
+
 		/*
 		 * If we froze any tuples, mark the buffer dirty, and write a WAL
 		 * record recording the changes.  We must log the changes to be
@@ -1167,6 +1368,8 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 		 */
 		if (nfrozen > 0)
 		{
+			vacrelstats->frozen_pages++;
+
 			START_CRIT_SECTION();
 
 			MarkBufferDirty(buf);
@@ -1188,7 +1391,7 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 			{
 				XLogRecPtr	recptr;
 
-				recptr = log_heap_freeze(onerel, buf, FreezeLimit,
+				recptr = log_heap_freeze(onerel, buf, freeze_cutoff,
 										 frozen, nfrozen);
 				PageSetLSN(page, recptr);
 			}
@@ -1201,7 +1404,7 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 		 * instead of doing a second scan.
 		 */
 		if (nindexes == 0 &&
-			vacrelstats->num_dead_tuples > 0)
+			vacrelstats->dead_tuples->num_tuples > 0)
 		{
 			/* Remove tuples from heap */
 			lazy_vacuum_page(onerel, blkno, buf, 0, vacrelstats, &vmbuffer);
@@ -1212,7 +1415,7 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 			 * not to reset latestRemovedXid since we want that value to be
 			 * valid.
 			 */
-			vacrelstats->num_dead_tuples = 0;
+			dead_tuples_reset(vacrelstats->dead_tuples);
 			vacuumed_pages++;
 
 			/*
@@ -1328,7 +1531,7 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 		 * page, so remember its free space as-is.  (This path will always be
 		 * taken if there are no indexes.)
 		 */
-		if (vacrelstats->num_dead_tuples == prev_dead_count)
+		if (vacrelstats->dead_tuples->num_tuples == prev_dead_count)
 			RecordPageWithFreeSpace(onerel, blkno, freespace);
 	}
 
@@ -1336,6 +1539,7 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 	pgstat_progress_update_param(PROGRESS_VACUUM_HEAP_BLKS_SCANNED, blkno);
 
 	pfree(frozen);
+	pfree(eager_frozen);
 
 	/* save stats for use later */
 	vacrelstats->tuples_deleted = tups_vacuumed;
@@ -1360,9 +1564,58 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 		vmbuffer = InvalidBuffer;
 	}
 
+	/*
+	 * If there are only a few dead item identifiers, on a tiny fraction of
+	 * the table's pages, a pass over every index to remove them costs far
+	 * more than it is worth.  Leave them in place for a later VACUUM instead;
+	 * they take just a line pointer each, and their pages are not marked
+	 * all-visible, so they will be visited again.  This is only safe if
+	 * every dead tuple is an LP_DEAD stub: a dead tuple that still has
+	 * storage would keep an old xmin around after relfrozenxid has been
+	 * advanced past it.  We also don't bother if an index pass already had
+	 * to happen.
+	 */
+	if (vacrelstats->dead_tuples->num_tuples > 0 &&
+		nindexes > 0 &&
+		vacrelstats->num_index_scans == 0 &&
+		!have_tupgone &&
+		vacrelstats->dead_tuples->num_blocks <
+		(double) nblocks * BYPASS_THRESHOLD_PAGES)
+	{
+		ereport(elevel,
+				(errmsg("\"%s\": index scan bypassed: %u pages from table (%.2f%% of total) have %d dead item identifiers",
+						relname,
+						(BlockNumber) vacrelstats->dead_tuples->num_blocks,
+						100.0 * vacrelstats->dead_tuples->num_blocks / nblocks,
+						vacrelstats->dead_tuples->num_tuples)));
+
+		/*
+		 * lazy_vacuum_heap won't visit the pages with dead items now, so
+		 * record their free space, as left by pruning, ourselves.  Their
+		 * upper FSM levels are updated by the FreeSpaceMapVacuumRange call
+		 * below.
+		 */
+		for (i = 0; i < vacrelstats->dead_tuples->num_blocks; i++)
+		{
+			BlockNumber tblk = LVDeadBlocks(vacrelstats->dead_tuples)[i].blkno;
+			Buffer		buf;
+			Size		freespace;
+
+			vacuum_delay_point();
+
+			buf = ReadBufferExtended(onerel, MAIN_FORKNUM, tblk, RBM_NORMAL,
+									 vac_strategy);
+			LockBuffer(buf, BUFFER_LOCK_SHARE);
+			freespace = PageGetHeapFreeSpace(BufferGetPage(buf));
+			UnlockReleaseBuffer(buf);
+			RecordPageWithFreeSpace(onerel, tblk, freespace);
+		}
+
+		dead_tuples_reset(vacrelstats->dead_tuples);
+	}
+
 	/* If any tuples need to be deleted, perform final vacuum cycle */
-	/* XXX put a threshold on min number of tuples here? */
-	if (vacrelstats->num_dead_tuples > 0)
+	if (vacrelstats->dead_tuples->num_tuples > 0)
 	{
 		const int	hvp_index[] = {
 			PROGRESS_VACUUM_PHASE,
@@ -1378,10 +1631,7 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 									 PROGRESS_VACUUM_PHASE_VACUUM_INDEX);
 
 		/* Remove index entries */
-		for (i = 0; i < nindexes; i++)
-			lazy_vacuum_index(Irel[i],
-							  &indstats[i],
-							  vacrelstats);
+		lazy_vacuum_all_indexes(Irel, indstats, vacrelstats, lps, nindexes);
 
 		/* Report that we are now vacuuming the heap */
 		hvp_val[0] = PROGRESS_VACUUM_PHASE_VACUUM_HEAP;
@@ -1407,9 +1657,18 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 	pgstat_progress_update_param(PROGRESS_VACUUM_PHASE,
 								 PROGRESS_VACUUM_PHASE_INDEX_CLEANUP);
 
-	/* Do post-vacuum cleanup and statistics update for each index */
-	for (i = 0; i < nindexes; i++)
-		lazy_cleanup_index(Irel[i], indstats[i], vacrelstats);
+	/* Do post-vacuum cleanup for each index */
+	lazy_cleanup_all_indexes(Irel, indstats, vacrelstats, lps, nindexes);
+
+	/*
+	 * Shut down the parallel workers, if any.  This must happen before the
+	 * index statistics are written, as that is not allowed in parallel mode.
+	 */
+	if (lps != NULL)
+		end_parallel_vacuum(lps, vacrelstats);
+
+	/* Update index statistics */
+	update_index_statistics(Irel, indstats, nindexes);
 
 	/* If no indexes, make log report that lazy_vacuum_heap would've made */
 	if (vacuumed_pages)
@@ -1436,6 +1695,14 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 									"%u frozen pages.\n",
 									vacrelstats->frozenskipped_pages),
 					 vacrelstats->frozenskipped_pages);
+	appendStringInfo(&buf, ngettext("Froze tuples on %u page, ",
+									"Froze tuples on %u pages, ",
+									vacrelstats->frozen_pages),
+					 vacrelstats->frozen_pages);
+	appendStringInfo(&buf, ngettext("%u page eagerly.\n",
+									"%u pages eagerly.\n",
+									vacrelstats->eager_frozen_pages),
+					 vacrelstats->eager_frozen_pages);
 	appendStringInfo(&buf, ngettext("%u page is entirely empty.\n",
 									"%u pages are entirely empty.\n",
 									empty_pages),
@@ -1466,16 +1733,18 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
 static void
 lazy_vacuum_heap(Relation onerel, LVRelStats *vacrelstats)
 {
-	int			tupindex;
+	LVDeadTuples *dead_tuples = vacrelstats->dead_tuples;
+	int			blockidx;
+	int			ntuples;
 	int			npages;
 	PGRUsage	ru0;
 	Buffer		vmbuffer = InvalidBuffer;
 
 	pg_rusage_init(&ru0);
+	ntuples = 0;
 	npages = 0;
 
-	tupindex = 0;
-	while (tupindex < vacrelstats->num_dead_tuples)
+	for (blockidx = 0; blockidx < dead_tuples->num_blocks; blockidx++)
 	{
 		BlockNumber tblk;
 		Buffer		buf;
@@ -1484,16 +1753,15 @@ lazy_vacuum_heap(Relation onerel, LVRelStats *vacrelstats)
 
 		vacuum_delay_point();
 
-		tblk = ItemPointerGetBlockNumber(&vacrelstats->dead_tuples[tupindex]);
+		tblk = LVDeadBlocks(dead_tuples)[blockidx].blkno;
 		buf = ReadBufferExtended(onerel, MAIN_FORKNUM, tblk, RBM_NORMAL,
 								 vac_strategy);
 		if (!ConditionalLockBufferForCleanup(buf))
 		{
 			ReleaseBuffer(buf);
-			++tupindex;
 			continue;
 		}
-		tupindex = lazy_vacuum_page(onerel, tblk, buf, tupindex, vacrelstats,
+		ntuples += lazy_vacuum_page(onerel, tblk, buf, blockidx, vacrelstats,
 									&vmbuffer);
 
 		/* Now that we've compacted the page, record its available space */
@@ -1514,7 +1782,7 @@ lazy_vacuum_heap(Relation onerel, LVRelStats *vacrelstats)
 	ereport(elevel,
 			(errmsg("\"%s\": removed %d row versions in %d pages",
 					RelationGetRelationName(onerel),
-					tupindex, npages),
+					ntuples, npages),
 			 errdetail_internal("%s", pg_rusage_show(&ru0))));
 }
 
@@ -1524,37 +1792,35 @@ lazy_vacuum_heap(Relation onerel, LVRelStats *vacrelstats)
  *
  * Caller must hold pin and buffer cleanup lock on the buffer.
  *
- * tupindex is the index in vacrelstats->dead_tuples of the first dead
- * tuple for this page.  We assume the rest follow sequentially.
- * The return value is the first tupindex after the tuples of this page.
+ * blockidx is the index of the page's entry in vacrelstats->dead_tuples.
+ * The return value is the number of tuples removed.
  */
 static int
 lazy_vacuum_page(Relation onerel, BlockNumber blkno, Buffer buffer,
-				 int tupindex, LVRelStats *vacrelstats, Buffer *vmbuffer)
+				 int blockidx, LVRelStats *vacrelstats, Buffer *vmbuffer)
 {
 	Page		page = BufferGetPage(buffer);
 	OffsetNumber unused[MaxOffsetNumber];
-	int			uncnt = 0;
+	int			uncnt;
+	int			i;
 	TransactionId visibility_cutoff_xid;
 	bool		all_frozen;
 
+	Assert(LVDeadBlocks(vacrelstats->dead_tuples)[blockidx].blkno == blkno);
+
 	pgstat_progress_update_param(PROGRESS_VACUUM_HEAP_BLKS_VACUUMED, blkno);
 
+	uncnt = dead_tuples_get_offsets(vacrelstats->dead_tuples, blockidx,
+									unused);
+
 	START_CRIT_SECTION();
 
-	for (; tupindex < vacrelstats->num_dead_tuples; tupindex++)
+	for (i = 0; i < uncnt; i++)
 	{
-		BlockNumber tblk;
-		OffsetNumber toff;
 		ItemId		itemid;
 
-		tblk = ItemPointerGetBlockNumber(&vacrelstats->dead_tuples[tupindex]);
-		if (tblk != blkno)
-			break;				/* past end of tuples for this block */
-		toff = ItemPointerGetOffsetNumber(&vacrelstats->dead_tuples[tupindex]);
-		itemid = PageGetItemId(page, toff);
+		itemid = PageGetItemId(page, unused[i]);
 		ItemIdSetUnused(itemid);
-		unused[uncnt++] = toff;
 	}
 
 	PageRepairFragmentation(page);
@@ -1616,7 +1882,61 @@ lazy_vacuum_page(Relation onerel, BlockNumber blkno, Buffer buffer,
 							  *vmbuffer, visibility_cutoff_xid, flags);
 	}
 
-	return tupindex;
+	return uncnt;
+}
+
+/*
+ *	lazy_prepare_eager_freeze() -- plan freezing all tuples on a page
+ *
+ * The page must be all-visible: every tuple on it is committed and visible
+ * to everyone, so each can be frozen using OldestXmin as the cutoff instead
+ * of FreezeLimit.  Fills frozen[] and returns the number of tuples that need
+ * freezing, or -1 if the page can't be made all-frozen this way.  We don't
+ * try if any tuple has a MultiXactId xmax, since freezing those may need a
+ * new multixact, which we don't want to create just to save a later visit.
+ */
+static int
+lazy_prepare_eager_freeze(Page page, TransactionId relfrozenxid,
+						  MultiXactId relminmxid,
+						  xl_heap_freeze_tuple *frozen)
+{
+	OffsetNumber offnum,
+				maxoff;
+	int			nfrozen = 0;
+
+	maxoff = PageGetMaxOffsetNumber(page);
+	for (offnum = FirstOffsetNumber;
+		 offnum <= maxoff;
+		 offnum = OffsetNumberNext(offnum))
+	{
+		ItemId		itemid;
+		HeapTupleHeader tupleheader;
+		bool		tuple_totally_frozen;
+
+		itemid = PageGetItemId(page, offnum);
+
+		/* Only normal items have tuples to freeze */
+		if (!ItemIdIsNormal(itemid))
+			continue;
+
+		tupleheader = (HeapTupleHeader) PageGetItem(page, itemid);
+
+		if ((tupleheader->t_infomask & HEAP_XMAX_IS_MULTI) &&
+			!(tupleheader->t_infomask & HEAP_XMAX_INVALID))
+			return -1;
+
+		if (heap_prepare_freeze_tuple(tupleheader,
+									  relfrozenxid, relminmxid,
+									  OldestXmin, MultiXactCutoff,
+									  &frozen[nfrozen],
+									  &tuple_totally_frozen))
+			frozen[nfrozen++].offset = offnum;
+
+		if (!tuple_totally_frozen)
+			return -1;
+	}
+
+	return nfrozen;
 }
 
 /*
@@ -1636,12 +1956,12 @@ lazy_check_needs_freeze(Buffer buf, bool *hastup)
 
 	*hastup = false;
 
-	/* If we hit an uninitialized page, we want to force vacuuming it. */
-	if (PageIsNew(page))
-		return true;
-
-	/* Quick out for ordinary empty page. */
-	if (PageIsEmpty(page))
+	/*
+	 * Uninitialized pages are routine now that relations are extended in
+	 * bulk, and neither they nor ordinary empty pages hold anything that
+	 * could need freezing.
+	 */
+	if (PageIsNew(page) || PageIsEmpty(page))
 		return false;
 
 	maxoff = PageGetMaxOffsetNumber(page);
@@ -1703,16 +2023,19 @@ lazy_vacuum_index(Relation indrel,
 	ereport(elevel,
 			(errmsg("scanned index \"%s\" to remove %d row versions",
 					RelationGetRelationName(indrel),
-					vacrelstats->num_dead_tuples),
+					vacrelstats->dead_tuples->num_tuples),
 			 errdetail_internal("%s", pg_rusage_show(&ru0))));
 }
 
 /*
  *	lazy_cleanup_index() -- do post-vacuum cleanup for one index relation.
+ *
+ *		The resulting statistics are returned in *stats; pg_class is updated
+ *		later by update_index_statistics().
  */
 static void
 lazy_cleanup_index(Relation indrel,
-				   IndexBulkDeleteResult *stats,
+				   IndexBulkDeleteResult **stats,
 				   LVRelStats *vacrelstats)
 {
 	IndexVacuumInfo ivinfo;
@@ -1733,38 +2056,468 @@ lazy_cleanup_index(Relation indrel,
 	ivinfo.num_heap_tuples = vacrelstats->new_rel_tuples;
 	ivinfo.strategy = vac_strategy;
 
-	stats = index_vacuum_cleanup(&ivinfo, stats);
+	*stats = index_vacuum_cleanup(&ivinfo, *stats);
 
-	if (!stats)
+	if (!*stats)
 		return;
 
-	/*
-	 * Now update statistics in pg_class, but only if the index says the count
-	 * is accurate.
-	 */
-	if (!stats->estimated_count)
-		vac_update_relstats(indrel,
-							stats->num_pages,
-							stats->num_index_tuples,
-							0,
-							false,
-							InvalidTransactionId,
-							InvalidMultiXactId,
-							false);
-
 	ereport(elevel,
 			(errmsg("index \"%s\" now contains %.0f row versions in %u pages",
 					RelationGetRelationName(indrel),
-					stats->num_index_tuples,
-					stats->num_pages),
+					(*stats)->num_index_tuples,
+					(*stats)->num_pages),
 			 errdetail("%.0f index row versions were removed.\n"
 					   "%u index pages have been deleted, %u are currently reusable.\n"
 					   "%s.",
-					   stats->tuples_removed,
-					   stats->pages_deleted, stats->pages_free,
+					   (*stats)->tuples_removed,
+					   (*stats)->pages_deleted, (*stats)->pages_free,
 					   pg_rusage_show(&ru0))));
+}
+
+/*
+ *	update_index_statistics() -- update pg_class for each index relation
+ *
+ *		Only indexes that say their tuple count is accurate are updated.
+ *		Frees the statistics as it goes.
+ */
+static void
+update_index_statistics(Relation *Irel, IndexBulkDeleteResult **stats,
+						int nindexes)
+{
+	int			i;
+
+	Assert(!IsInParallelMode());
+
+	for (i = 0; i < nindexes; i++)
+	{
+		if (stats[i] == NULL)
+			continue;
 
-	pfree(stats);
+		if (!stats[i]->estimated_count)
+			vac_update_relstats(Irel[i],
+								stats[i]->num_pages,
+								stats[i]->num_index_tuples,
+								0,
+								false,
+								InvalidTransactionId,
+								InvalidMultiXactId,
+								false);
+
+		pfree(stats[i]);
+		stats[i] = NULL;
+	}
+}
+
+/*
+ *	lazy_vacuum_all_indexes() -- vacuum all index relations.
+ *
+ *		Uses parallel workers when lps is not NULL.
+ */
+static void
+lazy_vacuum_all_indexes(Relation *Irel, IndexBulkDeleteResult **stats,
+						LVRelStats *vacrelstats, LVParallelState *lps,
+						int nindexes)
+{
+	int			i;
+
+	if (lps != NULL)
+	{
+		lazy_parallel_process_indexes(Irel, stats, vacrelstats, lps,
+									  nindexes, false);
+		return;
+	}
+
+	for (i = 0; i < nindexes; i++)
+		lazy_vacuum_index(Irel[i], &stats[i], vacrelstats);
+}
+
+/*
+ *	lazy_cleanup_all_indexes() -- do post-vacuum cleanup for all indexes.
+ *
+ *		Uses parallel workers when lps is not NULL.
+ */
+static void
+lazy_cleanup_all_indexes(Relation *Irel, IndexBulkDeleteResult **stats,
+						 LVRelStats *vacrelstats, LVParallelState *lps,
+						 int nindexes)
+{
+	int			i;
+
+	if (lps != NULL)
+	{
+		lazy_parallel_process_indexes(Irel, stats, vacrelstats, lps,
+									  nindexes, true);
+		return;
+	}
+
+	for (i = 0; i < nindexes; i++)
+		lazy_cleanup_index(Irel[i], &stats[i], vacrelstats);
+}
+
+/*
+ * compute_parallel_vacuum_workers - how many workers to use for indexes
+ *
+ * Only indexes of the core access methods are handed to workers: their
+ * bulk-delete state is a plain IndexBulkDeleteResult, which we can keep in
+ * shared memory between passes.  Any other index is processed by the leader.
+ * Indexes smaller than min_parallel_index_scan_size are still shared out, but
+ * don't count towards the number of workers requested.  As the leader also
+ * processes indexes, one less worker than there are such indexes is enough.
+ *
+ * can_parallel[] is set to true for the indexes workers may process.
+ */
+static int
+compute_parallel_vacuum_workers(Relation onerel, Relation *Irel, int nindexes,
+								bool *can_parallel)
+{
+	int			nindexes_parallel = 0;
+	int			i;
+
+	if (!IsUnderPostmaster || max_parallel_maintenance_workers == 0 ||
+		nindexes < 2 || RelationUsesLocalBuffers(onerel) ||
+		IsInParallelMode())
+		return 0;
+
+	for (i = 0; i < nindexes; i++)
+	{
+		Relation	indrel = Irel[i];
+
+		switch (indrel->rd_rel->relam)
+		{
+			case BTREE_AM_OID:
+			case HASH_AM_OID:
+			case GIST_AM_OID:
+			case GIN_AM_OID:
+			case SPGIST_AM_OID:
+			case BRIN_AM_OID:
+				can_parallel[i] = true;
+				break;
+			default:
+				can_parallel[i] = false;
+				break;
+		}
+
+		if (can_parallel[i] &&
+			RelationGetNumberOfBlocks(indrel) >= min_parallel_index_scan_size)
+			nindexes_parallel++;
+	}
+
+	if (nindexes_parallel < 2)
+		return 0;
+
+	return Min(nindexes_parallel - 1, max_parallel_maintenance_workers);
+}
+
+/*
+ * begin_parallel_vacuum - set up parallel index vacuuming
+ *
+ * Enters parallel mode, creates the parallel context and allocates the dead
+ * tuple array in its DSM segment.  Workers are only launched for each index
+ * pass.  Returns NULL if parallel index vacuuming is not to be used, in which
+ * case the caller must allocate the dead tuple store itself.
+ */
+static LVParallelState *
+begin_parallel_vacuum(Relation onerel, Relation *Irel, int nindexes,
+					  LVRelStats *vacrelstats, BlockNumber nblocks)
+{
+	LVParallelState *lps;
+	ParallelContext *pcxt;
+	LVShared   *lvshared;
+	LVDeadTuples *dead_tuples;
+	bool	   *can_parallel;
+	Size		est_shared;
+	Size		est_deadtuples;
+	int			nworkers;
+	int			querylen = 0;
+	int			i;
+
+	can_parallel = (bool *) palloc0(sizeof(bool) * nindexes);
+	nworkers = compute_parallel_vacuum_workers(onerel, Irel, nindexes,
+											   can_parallel);
+	if (nworkers <= 0)
+	{
+		pfree(can_parallel);
+		return NULL;
+	}
+
+	EnterParallelMode();
+	pcxt = CreateParallelContext("postgres", "parallel_vacuum_main",
+								 nworkers, true);
+
+	/* Estimate size for the shared state -- PARALLEL_VACUUM_KEY_SHARED */
+	est_shared = MAXALIGN(add_size(offsetof(LVShared, indstats),
+								   mul_size(sizeof(LVSharedIndStats),
+											nindexes)));
+	shm_toc_estimate_chunk(&pcxt->estimator, est_shared);
+
+	/* Estimate size for dead tuples -- PARALLEL_VACUUM_KEY_DEAD_TUPLES */
+	est_deadtuples = compute_dead_tuples_space(nblocks, true);
+	shm_toc_estimate_chunk(&pcxt->estimator, est_deadtuples);
+	shm_toc_estimate_keys(&pcxt->estimator, 2);
+
+	/* Finally, estimate PARALLEL_VACUUM_KEY_QUERY_TEXT space */
+	if (debug_query_string)
+	{
+		querylen = strlen(debug_query_string);
+		shm_toc_estimate_chunk(&pcxt->estimator, querylen + 1);
+		shm_toc_estimate_keys(&pcxt->estimator, 1);
+	}
+
+	/* Everyone's had a chance to ask for space, so now create the DSM */
+	InitializeParallelDSM(pcxt);
+
+	/* If no DSM segment was available, back out (do serial vacuum) */
+	if (pcxt->seg == NULL)
+	{
+		DestroyParallelContext(pcxt);
+		ExitParallelMode();
+		pfree(can_parallel);
+		return NULL;
+	}
+
+	lvshared = (LVShared *) shm_toc_allocate(pcxt->toc, est_shared);
+	MemSet(lvshared, 0, est_shared);
+	lvshared->relid = RelationGetRelid(onerel);
+	lvshared->elevel = elevel;
+	lvshared->nindexes = nindexes;
+	pg_atomic_init_u32(&lvshared->nextindex, 0);
+	for (i = 0; i < nindexes; i++)
+		lvshared->indstats[i].parallel_safe = can_parallel[i];
+	shm_toc_insert(pcxt->toc, PARALLEL_VACUUM_KEY_SHARED, lvshared);
+
+	dead_tuples = (LVDeadTuples *) shm_toc_allocate(pcxt->toc, est_deadtuples);
+	dead_tuples_init(dead_tuples, est_deadtuples);
+	shm_toc_insert(pcxt->toc, PARALLEL_VACUUM_KEY_DEAD_TUPLES, dead_tuples);
+	vacrelstats->dead_tuples = dead_tuples;
+
+	/* Store query string for workers */
+	if (debug_query_string)
+	{
+		char	   *sharedquery;
+
+		sharedquery = (char *) shm_toc_allocate(pcxt->toc, querylen + 1);
+		memcpy(sharedquery, debug_query_string, querylen + 1);
+		shm_toc_insert(pcxt->toc, PARALLEL_VACUUM_KEY_QUERY_TEXT, sharedquery);
+	}
+
+	lps = (LVParallelState *) palloc0(sizeof(LVParallelState));
+	lps->pcxt = pcxt;
+	lps->lvshared = lvshared;
+	lps->nlaunches = 0;
+
+	pfree(can_parallel);
+
+	return lps;
+}
+
+/*
+ * end_parallel_vacuum - shut down parallel index vacuuming
+ *
+ * The dead tuple store goes away with the DSM segment.
+ */
+static void
+end_parallel_vacuum(LVParallelState *lps, LVRelStats *vacrelstats)
+{
+	DestroyParallelContext(lps->pcxt);
+	ExitParallelMode();
+
+	vacrelstats->dead_tuples = NULL;
+
+	pfree(lps);
+}
+
+/*
+ * lazy_parallel_process_indexes - vacuum or clean up indexes in parallel
+ *
+ * Launches the workers for one index pass, processes indexes alongside them,
+ * and waits for them to finish.  stats[] is moved into shared memory before
+ * the pass and copied back afterwards.
+ */
+static void
+lazy_parallel_process_indexes(Relation *Irel, IndexBulkDeleteResult **stats,
+							  LVRelStats *vacrelstats, LVParallelState *lps,
+							  int nindexes, bool for_cleanup)
+{
+	LVShared   *lvshared = lps->lvshared;
+	ParallelContext *pcxt = lps->pcxt;
+	int			i;
+
+	/* Tell the workers what this pass is about */
+	lvshared->for_cleanup = for_cleanup;
+	lvshared->old_live_tuples = vacrelstats->old_live_tuples;
+	lvshared->new_rel_tuples = vacrelstats->new_rel_tuples;
+	lvshared->rel_pages = vacrelstats->rel_pages;
+	lvshared->tupcount_pages = vacrelstats->tupcount_pages;
+	pg_atomic_write_u32(&lvshared->nextindex, 0);
+
+	for (i = 0; i < nindexes; i++)
+	{
+		LVSharedIndStats *shared_indstats = &lvshared->indstats[i];
+
+		if (!shared_indstats->parallel_safe)
+			continue;
+
+		if (stats[i] != NULL)
+		{
+			memcpy(&shared_indstats->stats, stats[i],
+				   sizeof(IndexBulkDeleteResult));
+			shared_indstats->updated = true;
+		}
+		else
+			shared_indstats->updated = false;
+	}
+
+	/* Launch workers, reusing the DSM segment of any previous pass */
+	if (lps->nlaunches > 0)
+		ReinitializeParallelDSM(pcxt);
+	LaunchParallelWorkers(pcxt);
+	lps->nlaunches++;
+
+	if (for_cleanup)
+		ereport(elevel,
+				(errmsg("launched %d parallel vacuum workers for index cleanup (planned: %d)",
+						pcxt->nworkers_launched, pcxt->nworkers)));
+	else
+		ereport(elevel,
+				(errmsg("launched %d parallel vacuum workers for index vacuuming (planned: %d)",
+						pcxt->nworkers_launched, pcxt->nworkers)));
+
+	/* Join in, then take care of the indexes workers can't process */
+	parallel_vacuum_index_loop(Irel, lvshared, vacrelstats);
+
+	for (i = 0; i < nindexes; i++)
+	{
+		if (lvshared->indstats[i].parallel_safe)
+			continue;
+
+		if (for_cleanup)
+			lazy_cleanup_index(Irel[i], &stats[i], vacrelstats);
+		else
+			lazy_vacuum_index(Irel[i], &stats[i], vacrelstats);
+	}
+
+	WaitForParallelWorkersToFinish(pcxt);
+
+	/* Copy the results back into backend-local memory */
+	for (i = 0; i < nindexes; i++)
+	{
+		LVSharedIndStats *shared_indstats = &lvshared->indstats[i];
+
+		if (!shared_indstats->parallel_safe || !shared_indstats->updated)
+			continue;
+
+		if (stats[i] == NULL)
+			stats[i] = (IndexBulkDeleteResult *)
+				palloc(sizeof(IndexBulkDeleteResult));
+		memcpy(stats[i], &shared_indstats->stats,
+			   sizeof(IndexBulkDeleteResult));
+	}
+}
+
+/*
+ * parallel_vacuum_index_loop - process indexes until none are left
+ *
+ * Run by the leader and by each worker.  Indexes are claimed one at a time
+ * through the shared counter, and their bulk-delete state is updated in
+ * place in shared memory.
+ */
+static void
+parallel_vacuum_index_loop(Relation *Irel, LVShared *lvshared,
+						   LVRelStats *vacrelstats)
+{
+	for (;;)
+	{
+		LVSharedIndStats *shared_indstats;
+		IndexBulkDeleteResult *stats;
+		uint32		idx;
+
+		idx = pg_atomic_fetch_add_u32(&lvshared->nextindex, 1);
+		if (idx >= (uint32) lvshared->nindexes)
+			break;
+
+		shared_indstats = &lvshared->indstats[idx];
+		if (!shared_indstats->parallel_safe)
+			continue;
+
+		stats = shared_indstats->updated ? &shared_indstats->stats : NULL;
+
+		if (lvshared->for_cleanup)
+			lazy_cleanup_index(Irel[idx], &stats, vacrelstats);
+		else
+			lazy_vacuum_index(Irel[idx], &stats, vacrelstats);
+
+		/* Move freshly allocated results into shared memory */
+		if (stats != NULL && stats != &shared_indstats->stats)
+		{
+			memcpy(&shared_indstats->stats, stats,
+				   sizeof(IndexBulkDeleteResult));
+			shared_indstats->updated = true;
+			pfree(stats);
+		}
+	}
+}
+
+/*
+ * Perform index vacuuming or cleanup within a launched parallel process.
+ *
+ * Vacuum cost accounting is done separately in each worker, so the delay
+ * limit applies per process rather than to the operation as a whole.
+ */
+void
+parallel_vacuum_main(dsm_segment *seg, shm_toc *toc)
+{
+	LVShared   *lvshared;
+	LVRelStats	vacrelstats;
+	Relation	onerel;
+	Relation   *indrels;
+	int			nindexes;
+	char	   *sharedquery;
+
+	/* Set debug_query_string for individual workers first */
+	sharedquery = shm_toc_lookup(toc, PARALLEL_VACUUM_KEY_QUERY_TEXT, true);
+	debug_query_string = sharedquery;
+
+	/* Report the query string from leader */
+	pgstat_report_activity(STATE_RUNNING, debug_query_string);
+
+	lvshared = (LVShared *) shm_toc_lookup(toc, PARALLEL_VACUUM_KEY_SHARED,
+										   false);
+	elevel = lvshared->elevel;
+
+	/*
+	 * Open the table and its indexes.  The leader already holds these locks,
+	 * and group locking lets us share them.  vac_open_indexes() returns the
+	 * indexes in OID order, so our index numbers match the leader's.
+	 */
+	onerel = heap_open(lvshared->relid, ShareUpdateExclusiveLock);
+	vac_open_indexes(onerel, RowExclusiveLock, &nindexes, &indrels);
+	if (nindexes != lvshared->nindexes)
+		elog(ERROR, "parallel vacuum worker found %d indexes on \"%s\", expected %d",
+			 nindexes, RelationGetRelationName(onerel), lvshared->nindexes);
+
+	/* Set up the parts of LVRelStats that the index routines look at */
+	MemSet(&vacrelstats, 0, sizeof(LVRelStats));
+	vacrelstats.hasindex = true;
+	vacrelstats.old_live_tuples = lvshared->old_live_tuples;
+	vacrelstats.new_rel_tuples = lvshared->new_rel_tuples;
+	vacrelstats.rel_pages = lvshared->rel_pages;
+	vacrelstats.tupcount_pages = lvshared->tupcount_pages;
+	vacrelstats.dead_tuples = (LVDeadTuples *)
+		shm_toc_lookup(toc, PARALLEL_VACUUM_KEY_DEAD_TUPLES, false);
+
+	/* Set up our own buffer strategy and cost accounting */
+	vac_strategy = GetAccessStrategy(BAS_VACUUM);
+	VacuumCostActive = (VacuumCostDelay > 0);
+	VacuumCostBalance = 0;
+	VacuumPageHit = 0;
+	VacuumPageMiss = 0;
+	VacuumPageDirty = 0;
+
+	parallel_vacuum_index_loop(indrels, lvshared, &vacrelstats);
+
+	vac_close_indexes(nindexes, indrels, RowExclusiveLock);
+	heap_close(onerel, ShareUpdateExclusiveLock);
+	FreeAccessStrategy(vac_strategy);
 }
 
 /*
@@ -2071,113 +2824,270 @@ count_nondeletable_pages(Relation onerel, LVRelStats *vacrelstats)
 }
 
 /*
- * lazy_space_alloc - space allocation decisions for lazy vacuum
+ * compute_dead_tuples_space - size of the dead tuple store to allocate
  *
  * See the comments at the head of this file for rationale.
  */
-static void
-lazy_space_alloc(LVRelStats *vacrelstats, BlockNumber relblocks)
+static Size
+compute_dead_tuples_space(BlockNumber relblocks, bool hasindex)
 {
-	long		maxtuples;
+	long		maxitems;
 	int			vac_work_mem = IsAutoVacuumWorkerProcess() &&
 	autovacuum_work_mem != -1 ?
 	autovacuum_work_mem : maintenance_work_mem;
 
-	if (vacrelstats->hasindex)
+	if (hasindex)
 	{
-		maxtuples = (vac_work_mem * 1024L) / sizeof(ItemPointerData);
-		maxtuples = Min(maxtuples, INT_MAX);
-		maxtuples = Min(maxtuples, MaxAllocSize / sizeof(ItemPointerData));
+		maxitems = (vac_work_mem * 1024L) / sizeof(uint16);
+		maxitems = Min(maxitems, INT_MAX);
+		maxitems = Min(maxitems,
+					   (MaxAllocSize - offsetof(LVDeadTuples, items)) / sizeof(uint16));
 
 		/* curious coding here to ensure the multiplication can't overflow */
-		if ((BlockNumber) (maxtuples / LAZY_ALLOC_TUPLES) > relblocks)
-			maxtuples = relblocks * LAZY_ALLOC_TUPLES;
+		if ((BlockNumber) (maxitems / DEAD_TUPLES_PAGE_ITEMS) > relblocks)
+			maxitems = relblocks * DEAD_TUPLES_PAGE_ITEMS;
 
 		/* stay sane if small maintenance_work_mem */
-		maxtuples = Max(maxtuples, MaxHeapTuplesPerPage);
+		maxitems = Max(maxitems, DEAD_TUPLES_PAGE_ITEMS);
 	}
 	else
 	{
-		maxtuples = MaxHeapTuplesPerPage;
+		maxitems = DEAD_TUPLES_PAGE_ITEMS;
 	}
 
-	vacrelstats->num_dead_tuples = 0;
-	vacrelstats->max_dead_tuples = (int) maxtuples;
-	vacrelstats->dead_tuples = (ItemPointer)
-		palloc(maxtuples * sizeof(ItemPointerData));
+	return offsetof(LVDeadTuples, items) + maxitems * sizeof(uint16);
 }
 
 /*
- * lazy_record_dead_tuple - remember one deletable tuple
+ * dead_tuples_init - set up an empty dead tuple store in size bytes
  */
 static void
-lazy_record_dead_tuple(LVRelStats *vacrelstats,
-					   ItemPointer itemptr)
+dead_tuples_init(LVDeadTuples *dt, Size size)
 {
-	/*
-	 * The array shouldn't overflow under normal behavior, but perhaps it
-	 * could if we are given a really small maintenance_work_mem. In that
-	 * case, just forget the last few tuples (we'll get 'em next time).
-	 */
-	if (vacrelstats->num_dead_tuples < vacrelstats->max_dead_tuples)
+	dt->max_items = (size - offsetof(LVDeadTuples, items)) / sizeof(uint16);
+	dead_tuples_reset(dt);
+}
+
+/*
+ * dead_tuples_reset - forget all the dead tuples in the store
+ */
+static void
+dead_tuples_reset(LVDeadTuples *dt)
+{
+	dt->num_tuples = 0;
+	dt->num_blocks = 0;
+	dt->payload_start = dt->max_items;
+}
+
+/*
+ * dead_tuples_has_room_for_page - can the store take another page?
+ */
+static bool
+dead_tuples_has_room_for_page(LVDeadTuples *dt)
+{
+	return dt->payload_start - dt->num_blocks * (int) DEADBLOCK_ITEMS >=
+		(int) DEAD_TUPLES_PAGE_ITEMS;
+}
+
+/*
+ * dead_tuples_get_offsets - decode the dead offsets of one page
+ *
+ * Fills offsets[] (which must have room for MaxHeapTuplesPerPage entries)
+ * in ascending order, and returns their number.
+ */
+static int
+dead_tuples_get_offsets(LVDeadTuples *dt, int blockidx, OffsetNumber *offsets)
+{
+	uint32		data = LVDeadBlocks(dt)[blockidx].data;
+	uint16	   *payload;
+	int			noffsets = 0;
+	int			i;
+
+	switch (DEADBLOCK_FORMAT(data))
 	{
-		vacrelstats->dead_tuples[vacrelstats->num_dead_tuples] = *itemptr;
-		vacrelstats->num_dead_tuples++;
-		pgstat_progress_update_param(PROGRESS_VACUUM_NUM_DEAD_TUPLES,
-									 vacrelstats->num_dead_tuples);
+		case DEADBLOCK_INLINE:
+			for (i = 0; i < 2; i++)
+			{
+				if (DEADBLOCK_INLINE_OFFSET(data, i) != InvalidOffsetNumber)
+					offsets[noffsets++] = DEADBLOCK_INLINE_OFFSET(data, i);
+			}
+			break;
+		case DEADBLOCK_LIST:
+			payload = &dt->items[DEADBLOCK_PAYLOAD(data)];
+			noffsets = payload[0];
+			memcpy(offsets, &payload[1], noffsets * sizeof(OffsetNumber));
+			break;
+		case DEADBLOCK_BITMAP:
+			payload = &dt->items[DEADBLOCK_PAYLOAD(data)];
+			for (i = 0; i < payload[0]; i++)
+			{
+				uint16		word = payload[1 + i];
+				int			bit;
+
+				for (bit = 0; word != 0; bit++, word >>= 1)
+				{
+					if (word & 1)
+						offsets[noffsets++] = (OffsetNumber) (i * 16 + bit);
+				}
+			}
+			break;
+		default:
+			elog(ERROR, "unrecognized dead tuple block format %u",
+				 DEADBLOCK_FORMAT(data));
 	}
+
+	return noffsets;
 }
 
 /*
- *	lazy_tid_reaped() -- is a particular tid deletable?
- *
- *		This has the right signature to be an IndexBulkDeleteCallback.
+ * lazy_space_alloc - space allocation decisions for lazy vacuum
+ */
+static void
+lazy_space_alloc(LVRelStats *vacrelstats, BlockNumber relblocks)
+{
+	Size		space;
+
+	space = compute_dead_tuples_space(relblocks, vacrelstats->hasindex);
+
+	vacrelstats->dead_tuples = (LVDeadTuples *) palloc(space);
+	dead_tuples_init(vacrelstats->dead_tuples, space);
+}
+
+/*
+ * lazy_record_dead_tuples - remember the deletable tuples of one page
  *
- *		Assumes dead_tuples array is in sorted order.
+ * Pages must be recorded in ascending block order, and offsets[] must be in
+ * ascending order.  The caller must have checked that there's room for the
+ * page.
  */
-static bool
-lazy_tid_reaped(ItemPointer itemptr, void *state)
+static void
+lazy_record_dead_tuples(LVRelStats *vacrelstats, BlockNumber blkno,
+						OffsetNumber *offsets, int noffsets)
 {
-	LVRelStats *vacrelstats = (LVRelStats *) state;
-	ItemPointer res;
+	LVDeadTuples *dt = vacrelstats->dead_tuples;
+	LVDeadBlock *block;
+	uint16	   *payload;
+	int			nwords;
+	int			i;
+
+	if (noffsets == 0)
+		return;
 
-	res = (ItemPointer) bsearch((void *) itemptr,
-								(void *) vacrelstats->dead_tuples,
-								vacrelstats->num_dead_tuples,
-								sizeof(ItemPointerData),
-								vac_cmp_itemptr);
+	Assert(dead_tuples_has_room_for_page(dt));
+	Assert(dt->num_blocks == 0 ||
+		   LVDeadBlocks(dt)[dt->num_blocks - 1].blkno < blkno);
+	Assert(noffsets <= MaxHeapTuplesPerPage);
 
-	return (res != NULL);
+	block = &LVDeadBlocks(dt)[dt->num_blocks];
+	block->blkno = blkno;
+
+	/* Use the smallest format: inline, sorted list or bitmap */
+	nwords = offsets[noffsets - 1] / 16 + 1;
+	if (noffsets <= 2)
+	{
+		block->data = (uint32) offsets[0];
+		if (noffsets == 2)
+			block->data |= (uint32) offsets[1] << 15;
+	}
+	else if (noffsets <= nwords)
+	{
+		dt->payload_start -= 1 + noffsets;
+		payload = &dt->items[dt->payload_start];
+		payload[0] = (uint16) noffsets;
+		memcpy(&payload[1], offsets, noffsets * sizeof(OffsetNumber));
+		block->data = DEADBLOCK_MAKE(DEADBLOCK_LIST, dt->payload_start);
+	}
+	else
+	{
+		dt->payload_start -= 1 + nwords;
+		payload = &dt->items[dt->payload_start];
+		payload[0] = (uint16) nwords;
+		memset(&payload[1], 0, nwords * sizeof(uint16));
+		for (i = 0; i < noffsets; i++)
+			payload[1 + offsets[i] / 16] |= (uint16) (1 << (offsets[i] % 16));
+		block->data = DEADBLOCK_MAKE(DEADBLOCK_BITMAP, dt->payload_start);
+	}
+
+	dt->num_blocks++;
+	dt->num_tuples += noffsets;
+	pgstat_progress_update_param(PROGRESS_VACUUM_NUM_DEAD_TUPLES,
+								 dt->num_tuples);
 }
 
 /*
- * Comparator routines for use with qsort() and bsearch().
+ *	lazy_tid_reaped() -- is a particular tid deletable?
+ *
+ *		This has the right signature to be an IndexBulkDeleteCallback.
+ *
+ *		We binary-search the block entries, which are in block number order,
+ *		and then look the offset up in the block's own format.
  */
-static int
-vac_cmp_itemptr(const void *left, const void *right)
+static bool
+lazy_tid_reaped(ItemPointer itemptr, void *state)
 {
-	BlockNumber lblk,
-				rblk;
-	OffsetNumber loff,
-				roff;
+	LVRelStats *vacrelstats = (LVRelStats *) state;
+	LVDeadTuples *dt = vacrelstats->dead_tuples;
+	LVDeadBlock *blocks = LVDeadBlocks(dt);
+	BlockNumber blkno = ItemPointerGetBlockNumber(itemptr);
+	OffsetNumber offnum = ItemPointerGetOffsetNumber(itemptr);
+	uint16	   *payload;
+	uint32		data;
+	int			lo,
+				hi;
+
+	/* Quick exit for blocks outside the range we have anything for */
+	if (dt->num_blocks == 0 ||
+		blkno < blocks[0].blkno ||
+		blkno > blocks[dt->num_blocks - 1].blkno)
+		return false;
 
-	lblk = ItemPointerGetBlockNumber((ItemPointer) left);
-	rblk = ItemPointerGetBlockNumber((ItemPointer) right);
+	lo = 0;
+	hi = dt->num_blocks - 1;
+	while (lo < hi)
+	{
+		int			mid = lo + (hi - lo) / 2;
 
-	if (lblk < rblk)
-		return -1;
-	if (lblk > rblk)
-		return 1;
+		if (blocks[mid].blkno < blkno)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (blocks[lo].blkno != blkno)
+		return false;
 
-	loff = ItemPointerGetOffsetNumber((ItemPointer) left);
-	roff = ItemPointerGetOffsetNumber((ItemPointer) right);
+	data = blocks[lo].data;
 
-	if (loff < roff)
-		return -1;
-	if (loff > roff)
-		return 1;
+	switch (DEADBLOCK_FORMAT(data))
+	{
+		case DEADBLOCK_INLINE:
+			return (DEADBLOCK_INLINE_OFFSET(data, 0) == offnum ||
+					DEADBLOCK_INLINE_OFFSET(data, 1) == offnum);
+		case DEADBLOCK_LIST:
+			payload = &dt->items[DEADBLOCK_PAYLOAD(data)];
+			lo = 1;
+			hi = payload[0];
+			while (lo <= hi)
+			{
+				int			mid = lo + (hi - lo) / 2;
+
+				if (payload[mid] < offnum)
+					lo = mid + 1;
+				else if (payload[mid] > offnum)
+					hi = mid - 1;
+				else
+					return true;
+			}
+			return false;
+		case DEADBLOCK_BITMAP:
+			payload = &dt->items[DEADBLOCK_PAYLOAD(data)];
+			if (offnum / 16 >= payload[0])
+				return false;
+			return (payload[1 + offnum / 16] & (1 << (offnum % 16))) != 0;
+	}
 
-	return 0;
+	elog(ERROR, "unrecognized dead tuple block format %u",
+		 DEADBLOCK_FORMAT(data));
+	return false;				/* keep compiler quiet */
 }
 
 /*
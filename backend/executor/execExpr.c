@@ -59,6 +59,20 @@ typedef struct ExprSetupInfo
 	List	   *multiexpr_subplans;
 } ExprSetupInfo;
 
+/*
+ * Which Vars are passed as function arguments, per input slot: "once" holds
+ * the attribute numbers seen at least once, "multi" those seen again.
+ */
+typedef struct DetoastRefsInfo
+{
+	Bitmapset  *once[3];
+	Bitmapset  *multi[3];
+} DetoastRefsInfo;
+
+#define DETOAST_INNER	0
+#define DETOAST_OUTER	1
+#define DETOAST_SCAN	2
+
 static void ExecReadyExpr(ExprState *state);
 static void ExecInitExprRec(Expr *node, ExprState *state,
 				Datum *resv, bool *resnull);
@@ -68,6 +82,9 @@ static void ExecInitFunc(ExprEvalStep *scratch, Expr *node, List *args,
 static void ExecCreateExprSetupSteps(ExprState *state, Node *node);
 static void ExecPushExprSetupSteps(ExprState *state, ExprSetupInfo *info);
 static bool expr_setup_walker(Node *node, ExprSetupInfo *info);
+static bool ExecFuncArgNeedsDetoast(ExprState *state, Expr *arg);
+static void detoast_refs_count(List *args, DetoastRefsInfo *info);
+static bool detoast_refs_walker(Node *node, DetoastRefsInfo *info);
 static void ExecInitWholeRowVar(ExprEvalStep *scratch, Var *variable,
 					ExprState *state);
 static void ExecInitArrayRef(ExprEvalStep *scratch, ArrayRef *aref,
@@ -2284,6 +2301,32 @@ ExecInitFunc(ExprEvalStep *scratch, Expr *node, List *args, Oid funcid,
 			fcinfo->arg[argno] = con->constvalue;
 			fcinfo->argnull[argno] = con->constisnull;
 		}
+		else if (ExecFuncArgNeedsDetoast(state, arg))
+		{
+			ExprEvalStep *varstep;
+
+			/*
+			 * Compile the Var as usual, then switch its step to the variant
+			 * that goes through the slot's detoast cache.
+			 */
+			ExecInitExprRec(arg, state,
+							&fcinfo->arg[argno], &fcinfo->argnull[argno]);
+			varstep = &state->steps[state->steps_len - 1];
+			switch (varstep->opcode)
+			{
+				case EEOP_INNER_VAR:
+					varstep->opcode = EEOP_INNER_VAR_DETOAST;
+					break;
+				case EEOP_OUTER_VAR:
+					varstep->opcode = EEOP_OUTER_VAR_DETOAST;
+					break;
+				case EEOP_SCAN_VAR:
+					varstep->opcode = EEOP_SCAN_VAR_DETOAST;
+					break;
+				default:
+					elog(ERROR, "unexpected opcode %d for Var", (int) varstep->opcode);
+			}
+		}
 		else
 		{
 			ExecInitExprRec(arg, state,
@@ -2458,6 +2501,132 @@ expr_setup_walker(Node *node, ExprSetupInfo *info)
 								  (void *) info);
 }
 
+/*
+ * Should this function argument be fetched through the slot's detoast cache?
+ *
+ * Functions detoast their varlena arguments themselves, so when the same
+ * toasted column is passed to several functions, say a few jsonb ->>
+ * extractions in the targetlist and another in the qual, each of them would
+ * fetch and decompress it again.  For a user-column Var of a varlena type
+ * that the parent node's qual and targetlist pass to functions at least
+ * twice, we instead let the Var step detoast the value once per tuple.
+ * Columns used only once are left alone: the function might need just a
+ * slice of the value, or its size, or nothing at all, and a bare Var that
+ * is merely passed up the plan should keep its compact TOAST pointer.
+ */
+static bool
+ExecFuncArgNeedsDetoast(ExprState *state, Expr *arg)
+{
+	PlanState  *parent = state->parent;
+	Var		   *variable;
+	bool		multi;
+
+	if (!IsA(arg, Var) || parent == NULL)
+		return false;
+	variable = (Var *) arg;
+	if (variable->varattno <= 0 || variable->varlevelsup != 0)
+		return false;
+
+	/* count the plan node's function-argument Vars on first use */
+	if (!parent->ps_DetoastValid)
+	{
+		DetoastRefsInfo info;
+
+		memset(&info, 0, sizeof(info));
+		detoast_refs_walker((Node *) parent->plan->qual, &info);
+		detoast_refs_walker((Node *) parent->plan->targetlist, &info);
+		parent->ps_DetoastInner = info.multi[DETOAST_INNER];
+		parent->ps_DetoastOuter = info.multi[DETOAST_OUTER];
+		parent->ps_DetoastScan = info.multi[DETOAST_SCAN];
+		parent->ps_DetoastValid = true;
+	}
+
+	switch (variable->varno)
+	{
+		case INNER_VAR:
+			multi = bms_is_member(variable->varattno, parent->ps_DetoastInner);
+			break;
+		case OUTER_VAR:
+			multi = bms_is_member(variable->varattno, parent->ps_DetoastOuter);
+			break;
+
+			/* INDEX_VAR is handled by default case */
+
+		default:
+			multi = bms_is_member(variable->varattno, parent->ps_DetoastScan);
+			break;
+	}
+
+	return multi && get_typlen(variable->vartype) == -1;
+}
+
+/*
+ * Count the Vars among a function's arguments, for ExecFuncArgNeedsDetoast.
+ */
+static void
+detoast_refs_count(List *args, DetoastRefsInfo *info)
+{
+	ListCell   *lc;
+
+	foreach(lc, args)
+	{
+		Var		   *variable = (Var *) lfirst(lc);
+		int			kind;
+
+		if (!IsA(variable, Var) ||
+			variable->varattno <= 0 || variable->varlevelsup != 0)
+			continue;
+
+		switch (variable->varno)
+		{
+			case INNER_VAR:
+				kind = DETOAST_INNER;
+				break;
+			case OUTER_VAR:
+				kind = DETOAST_OUTER;
+				break;
+			default:
+				kind = DETOAST_SCAN;
+				break;
+		}
+
+		if (bms_is_member(variable->varattno, info->once[kind]))
+			info->multi[kind] = bms_add_member(info->multi[kind],
+											   variable->varattno);
+		else
+			info->once[kind] = bms_add_member(info->once[kind],
+											  variable->varattno);
+	}
+}
+
+/*
+ * detoast_refs_walker: expression walker for ExecFuncArgNeedsDetoast
+ *
+ * Looks at the node types that ExecInitFunc compiles, and like
+ * expr_setup_walker skips what isn't evaluated in this node's econtext.
+ */
+static bool
+detoast_refs_walker(Node *node, DetoastRefsInfo *info)
+{
+	if (node == NULL)
+		return false;
+	if (IsA(node, FuncExpr))
+		detoast_refs_count(((FuncExpr *) node)->args, info);
+	else if (IsA(node, OpExpr) ||
+			 IsA(node, DistinctExpr) ||
+			 IsA(node, NullIfExpr))
+		detoast_refs_count(((OpExpr *) node)->args, info);
+
+	if (IsA(node, Aggref))
+		return false;
+	if (IsA(node, WindowFunc))
+		return false;
+	if (IsA(node, GroupingFunc))
+		return false;
+	return expression_tree_walker(node, detoast_refs_walker,
+								  (void *) info);
+}
+
 /*
  * Prepare step for the evaluation of a whole-row variable.
  * The caller still has to push the step.
@@ -314,6 +314,9 @@ ExecInterpExpr(ExprState *state, ExprContext *econtext, bool *isnull)
 		&&CASE_EEOP_INNER_VAR,
 		&&CASE_EEOP_OUTER_VAR,
 		&&CASE_EEOP_SCAN_VAR,
+		&&CASE_EEOP_INNER_VAR_DETOAST,
+		&&CASE_EEOP_OUTER_VAR_DETOAST,
+		&&CASE_EEOP_SCAN_VAR_DETOAST,
 		&&CASE_EEOP_INNER_SYSVAR,
 		&&CASE_EEOP_OUTER_SYSVAR,
 		&&CASE_EEOP_SCAN_SYSVAR,
@@ -488,6 +491,16 @@ ExecInterpExpr(ExprState *state, ExprContext *econtext, bool *isnull)
 			EEO_NEXT();
 		}
 
+		EEO_CASE(EEOP_INNER_VAR_DETOAST)
+		EEO_CASE(EEOP_OUTER_VAR_DETOAST)
+		EEO_CASE(EEOP_SCAN_VAR_DETOAST)
+		{
+			/* too rare and too expensive to be worth inlining */
+			ExecEvalVarDetoast(state, op, econtext);
+
+			EEO_NEXT();
+		}
+
 		EEO_CASE(EEOP_INNER_SYSVAR)
 		{
 			int			attnum = op->d.var.attnum;
@@ -1823,6 +1836,7 @@ CheckExprStillValid(ExprState *state, ExprContext *econtext)
 		switch (ExecEvalStepOp(state, op))
 		{
 			case EEOP_INNER_VAR:
+			case EEOP_INNER_VAR_DETOAST:
 				{
 					int			attnum = op->d.var.attnum;
 
@@ -1831,6 +1845,7 @@ CheckExprStillValid(ExprState *state, ExprContext *econtext)
 				}
 
 			case EEOP_OUTER_VAR:
+			case EEOP_OUTER_VAR_DETOAST:
 				{
 					int			attnum = op->d.var.attnum;
 
@@ -1839,6 +1854,7 @@ CheckExprStillValid(ExprState *state, ExprContext *econtext)
 				}
 
 			case EEOP_SCAN_VAR:
+			case EEOP_SCAN_VAR_DETOAST:
 				{
 					int			attnum = op->d.var.attnum;
 
@@ -3817,6 +3833,43 @@ ExecEvalAlternativeSubPlan(ExprState *state, ExprEvalStep *op, ExprContext *econ
 	*op->resvalue = ExecAlternativeSubPlan(asstate, econtext, op->resnull);
 }
 
+/*
+ * Evaluate a Var of a varlena column that several expressions of the same
+ * plan node pass to functions.  The value is detoasted through the slot's
+ * detoast cache, so it's fetched and decompressed at most once per tuple
+ * however many of those functions see it.
+ */
+void
+ExecEvalVarDetoast(ExprState *state, ExprEvalStep *op, ExprContext *econtext)
+{
+	int			attnum = op->d.var.attnum;
+	TupleTableSlot *slot;
+
+	switch (ExecEvalStepOp(state, op))
+	{
+		case EEOP_INNER_VAR_DETOAST:
+			slot = econtext->ecxt_innertuple;
+			break;
+		case EEOP_OUTER_VAR_DETOAST:
+			slot = econtext->ecxt_outertuple;
+			break;
+		case EEOP_SCAN_VAR_DETOAST:
+			slot = econtext->ecxt_scantuple;
+			break;
+		default:
+			elog(ERROR, "unexpected opcode in ExecEvalVarDetoast");
+			slot = NULL;		/* keep compiler quiet */
+	}
+
+	/* See EEOP_INNER_VAR comments */
+	Assert(attnum >= 0 && attnum < slot->tts_nvalid);
+	*op->resnull = slot->tts_isnull[attnum];
+	if (*op->resnull)
+		*op->resvalue = (Datum) 0;
+	else
+		*op->resvalue = ExecFetchSlotDetoastedAttr(slot, attnum + 1);
+}
+
 /*
  * Evaluate a wholerow Var expression.
  *
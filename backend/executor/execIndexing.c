@@ -262,9 +262,13 @@ ExecCloseIndices(ResultRelInfo *resultRelInfo)
  *		If 'arbiterIndexes' is nonempty, noDupErr applies only to
  *		those indexes.  NIL means noDupErr applies to all indexes.
  *
- *		CAUTION: this must not be called for a HOT update.
- *		We can't defend against that here for lack of info.
- *		Should we change the API to make it safer?
+ *		If 'onlySummarizing' is true, only summarizing indexes (see
+ *		amsummarizing) are updated.  That is what a HOT update that
+ *		changed a summarized column needs.
+ *
+ *		CAUTION: this must not be called for a HOT update unless
+ *		onlySummarizing is true.  We can't defend against that here for
+ *		lack of info.  Should we change the API to make it safer?
  * ----------------------------------------------------------------
  */
 List *
@@ -273,7 +277,8 @@ ExecInsertIndexTuples(TupleTableSlot *slot,
 					  EState *estate,
 					  bool noDupErr,
 					  bool *specConflict,
-					  List *arbiterIndexes)
+					  List *arbiterIndexes,
+					  bool onlySummarizing)
 {
 	List	   *result = NIL;
 	ResultRelInfo *resultRelInfo;
@@ -324,6 +329,10 @@ ExecInsertIndexTuples(TupleTableSlot *slot,
 		if (!indexInfo->ii_ReadyForInserts)
 			continue;
 
+		/* Skip non-summarizing indexes if we only need summarizing ones */
+		if (onlySummarizing && !indexRelation->rd_amroutine->amsummarizing)
+			continue;
+
 		/* Check for partial index */
 		if (indexInfo->ii_Predicate != NIL)
 		{
@@ -41,6 +41,7 @@
  *		ExecCopySlotMinimalTuple - build a minimal physical tuple from a slot
  *		ExecMaterializeSlot		- convert virtual to physical storage
  *		ExecCopySlot			- copy one slot's contents to another
+ *		ExecFetchSlotDetoastedAttr - get a column detoasted, once per tuple
  *
  *	 CONVENIENCE INITIALIZATION ROUTINES
  *		ExecInitResultTupleSlot    \	convenience routines to initialize
@@ -89,11 +90,14 @@
 #include "storage/bufmgr.h"
 #include "utils/builtins.h"
 #include "utils/lsyscache.h"
+#include "utils/memutils.h"
 #include "utils/typcache.h"
 
 
 static TupleDesc ExecTypeFromTLInternal(List *targetList,
 					   bool hasoid, bool skipjunk);
+static void ExecClearSlotDetoasted(TupleTableSlot *slot);
+static void ExecFreeSlotDetoasted(TupleTableSlot *slot);
 
 
 /* ----------------------------------------------------------------
@@ -203,6 +207,7 @@ ExecResetTupleTable(List *tupleTable,	/* tuple table */
 		/* If shouldFree, release memory occupied by the slot itself */
 		if (shouldFree)
 		{
+			ExecFreeSlotDetoasted(slot);
 			if (!slot->tts_fixedTupleDescriptor)
 			{
 				if (slot->tts_values)
@@ -251,6 +256,7 @@ ExecDropSingleTupleTableSlot(TupleTableSlot *slot)
 	ExecClearTuple(slot);
 	if (slot->tts_tupleDescriptor)
 		ReleaseTupleDesc(slot->tts_tupleDescriptor);
+	ExecFreeSlotDetoasted(slot);
 	if (!slot->tts_fixedTupleDescriptor)
 	{
 		if (slot->tts_values)
@@ -297,6 +303,11 @@ ExecSetSlotDescriptor(TupleTableSlot *slot, /* slot to change */
 		pfree(slot->tts_values);
 	if (slot->tts_isnull)
 		pfree(slot->tts_isnull);
+	if (slot->tts_detoasted)
+	{
+		pfree(slot->tts_detoasted);
+		slot->tts_detoasted = NULL;
+	}
 
 	/*
 	 * Install the new descriptor; if it's refcounted, bump its refcount.
@@ -386,6 +397,7 @@ ExecStoreTuple(HeapTuple tuple,
 
 	/* Mark extracted state invalid */
 	slot->tts_nvalid = 0;
+	ExecClearSlotDetoasted(slot);
 
 	/*
 	 * If tuple is on a disk page, keep the page pinned as long as we hold a
@@ -459,6 +471,7 @@ ExecStoreMinimalTuple(MinimalTuple mtup,
 
 	/* Mark extracted state invalid */
 	slot->tts_nvalid = 0;
+	ExecClearSlotDetoasted(slot);
 
 	return slot;
 }
@@ -505,6 +518,7 @@ ExecClearTuple(TupleTableSlot *slot)	/* slot in which to store tuple */
 	 */
 	slot->tts_isempty = true;
 	slot->tts_nvalid = 0;
+	ExecClearSlotDetoasted(slot);
 
 	return slot;
 }
@@ -865,6 +879,90 @@ ExecCopySlot(TupleTableSlot *dstslot, TupleTableSlot *srcslot)
 	return ExecStoreTuple(newTuple, dstslot, InvalidBuffer, true);
 }
 
+/* --------------------------------
+ *		ExecFetchSlotDetoastedAttr
+ *			Return the value of column attnum (counting from 1) in
+ *			detoasted form.
+ *
+ *		The column must already have been extracted into tts_values.  A
+ *		value that is stored out of line or compressed is detoasted on the
+ *		first call and remembered until the slot's contents change, so any
+ *		number of expressions can share one fetch and decompression per
+ *		tuple.  Other values are returned as they are.
+ * --------------------------------
+ */
+Datum
+ExecFetchSlotDetoastedAttr(TupleTableSlot *slot, int attnum)
+{
+	int			natts = slot->tts_tupleDescriptor->natts;
+	Datum		value;
+	struct varlena *attr;
+	MemoryContext oldContext;
+
+	Assert(attnum > 0 && attnum <= slot->tts_nvalid);
+
+	value = slot->tts_values[attnum - 1];
+	if (slot->tts_isnull[attnum - 1])
+		return value;
+
+	/* expanded objects are already in memory; leave them alone */
+	attr = (struct varlena *) DatumGetPointer(value);
+	if (!(VARATT_IS_EXTERNAL_ONDISK(attr) ||
+		  VARATT_IS_EXTERNAL_INDIRECT(attr) ||
+		  VARATT_IS_COMPRESSED(attr)))
+		return value;
+
+	if (slot->tts_detoasted != NULL && slot->tts_detoasted[attnum - 1] != 0)
+		return slot->tts_detoasted[attnum - 1];
+
+	if (slot->tts_detoasted == NULL)
+		slot->tts_detoasted = (Datum *)
+			MemoryContextAllocZero(slot->tts_mcxt, natts * sizeof(Datum));
+	if (slot->tts_detoastcxt == NULL)
+		slot->tts_detoastcxt = AllocSetContextCreate(slot->tts_mcxt,
+													 "TupleTableSlot detoasted values",
+													 ALLOCSET_DEFAULT_SIZES);
+
+	oldContext = MemoryContextSwitchTo(slot->tts_detoastcxt);
+	value = PointerGetDatum(heap_tuple_untoast_attr(attr));
+	MemoryContextSwitchTo(oldContext);
+
+	slot->tts_detoasted[attnum - 1] = value;
+	slot->tts_detoastdirty = true;
+
+	return value;
+}
+
+/*
+ * Forget any detoasted values cached for the slot's previous contents.
+ */
+static void
+ExecClearSlotDetoasted(TupleTableSlot *slot)
+{
+	if (!slot->tts_detoastdirty)
+		return;
+
+	MemoryContextReset(slot->tts_detoastcxt);
+	memset(slot->tts_detoasted, 0,
+		   slot->tts_tupleDescriptor->natts * sizeof(Datum));
+	slot->tts_detoastdirty = false;
+}
+
+/*
+ * Release the slot's detoast cache altogether, when the slot goes away.
+ */
+static void
+ExecFreeSlotDetoasted(TupleTableSlot *slot)
+{
+	if (slot->tts_detoastcxt)
+		MemoryContextDelete(slot->tts_detoastcxt);
+	if (slot->tts_detoasted)
+		pfree(slot->tts_detoasted);
+	slot->tts_detoastcxt = NULL;
+	slot->tts_detoasted = NULL;
+	slot->tts_detoastdirty = false;
+}
+
 
 /* ----------------------------------------------------------------
  *				convenience initialization routines
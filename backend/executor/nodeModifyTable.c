@@ -535,7 +535,7 @@ ExecInsert(ModifyTableState *mtstate,
             //插入与之相关的索引项
 			recheckIndexes = ExecInsertIndexTuples(slot, &(tuple->t_self),
 												   estate, true, &specConflict,
-												   arbiterIndexes);
+												   arbiterIndexes, false);
 
 			/* adjust the tuple's state accordingly */
 			if (!specConflict)
@@ -584,7 +584,7 @@ ExecInsert(ModifyTableState *mtstate,
 			if (resultRelInfo->ri_NumIndices > 0)
 				recheckIndexes = ExecInsertIndexTuples(slot, &(tuple->t_self),
 													   estate, false, NULL,
-													   NIL);//索引
+													   NIL, false);//索引
 		}
 	}
 
@@ -1130,6 +1130,7 @@ ExecUpdate(ModifyTableState *mtstate,
 	else
 	{
 		LockTupleMode lockmode;
+		bool		summarized_update;
 		bool		partition_constraint_failed;
 
 		/*
@@ -1323,7 +1324,7 @@ lreplace:;
 							 estate->es_output_cid,
 							 estate->es_crosscheck_snapshot,
 							 true /* wait for commit */ ,
-							 &hufd, &lockmode);
+							 &hufd, &lockmode, &summarized_update);
 		switch (result)
 		{
 			case HeapTupleSelfUpdated:
@@ -1414,11 +1415,14 @@ lreplace:;
 		 * Note: heap_update returns the tid (location) of the new tuple in
 		 * the t_self field.
 		 *
-		 * If it's a HOT update, we mustn't insert new index entries.
+		 * If it's a HOT update, we mustn't insert new index entries, except
+		 * into summarizing indexes whose columns the update changed.
 		 */
-		if (resultRelInfo->ri_NumIndices > 0 && !HeapTupleIsHeapOnly(tuple))
+		if (resultRelInfo->ri_NumIndices > 0 &&
+			(!HeapTupleIsHeapOnly(tuple) || summarized_update))
 			recheckIndexes = ExecInsertIndexTuples(slot, &(tuple->t_self),
-												   estate, false, NULL, NIL);
+												   estate, false, NULL, NIL,
+												   HeapTupleIsHeapOnly(tuple));
 	}
 
 	if (canSetTag)
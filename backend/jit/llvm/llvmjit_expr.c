@@ -449,6 +449,14 @@ llvm_compile_expr(ExprState *state)
 					break;
 				}
 
+			case EEOP_INNER_VAR_DETOAST:
+			case EEOP_OUTER_VAR_DETOAST:
+			case EEOP_SCAN_VAR_DETOAST:
+				build_EvalXFunc(b, mod, "ExecEvalVarDetoast",
+								v_state, v_econtext, op);
+				LLVMBuildBr(b, opblocks[i + 1]);
+				break;
+
 			case EEOP_WHOLEROW:
 				build_EvalXFunc(b, mod, "ExecEvalWholeRowVar",
 								v_state, v_econtext, op);
@@ -36,6 +36,7 @@
 
 #include "access/heapam.h"
 #include "access/htup_details.h"
+#include "access/slru.h"
 #include "access/transam.h"
 #include "access/twophase_rmgr.h"
 #include "access/xact.h"
@@ -821,6 +822,9 @@ pgstat_report_stat(bool force)
 	TabStatusArray *tsa;
 	int			i;
 
+	/* Publish SLRU hit counts; this is cheap, so do it every time */
+	SimpleLruReportStats();
+
 	/* Don't expend a clock check if nothing to do */
 	if ((pgStatTabList == NULL || pgStatTabList->tsa_used == 0) &&
 		pgStatXactCommit == 0 && pgStatXactRollback == 0 &&
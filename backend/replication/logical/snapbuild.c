@@ -562,11 +562,13 @@ SnapBuildBuildSnapshot(SnapBuild *builder)
 	snapshot->subxip = NULL;
 
 	snapshot->suboverflowed = false;
+	snapshot->xidsSorted = false;
 	snapshot->takenDuringRecovery = false;
 	snapshot->copied = false;
 	snapshot->curcid = FirstCommandId;
 	snapshot->active_count = 0;
 	snapshot->regd_count = 0;
+	snapshot->snapXactCompletionCount = 0;
 
 	return snapshot;
 }
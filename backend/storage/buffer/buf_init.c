@@ -134,6 +134,7 @@ InitBufferPool(void)
 
 			pg_atomic_init_u32(&buf->state, 0);
 			buf->wait_backend_pid = 0;
+			buf->first_dirty_lsn = InvalidXLogRecPtr;
 
 			buf->buf_id = i;
 
@@ -9,6 +9,10 @@
  * in most cases the caller needs to adjust the buffer header contents
  * before the lock is released (see notes in README).
  *
+ * Alongside the hashtable we keep an array of lookup hints, which can be
+ * read without any lock.  A hint is only a guess at which buffer holds a
+ * tag: whoever uses one must pin the buffer and recheck its tag.
+ *
  *
  * Portions Copyright (c) 1996-2018, PostgreSQL Global Development Group
  * Portions Copyright (c) 1994, Regents of the University of California
@@ -23,6 +27,7 @@
 
 #include "storage/bufmgr.h"
 #include "storage/buf_internals.h"
+#include "utils/dynahash.h"
 
 
 /* entry for buffer lookup hashtable */
@@ -34,6 +39,15 @@ typedef struct
 
 static HTAB *SharedBufHash;
 
+/*
+ * Lookup hints, indexed by hash code modulo the (power of 2) array size.
+ * Each slot holds a buffer ID plus one, or zero if it's empty.
+ */
+static pg_atomic_uint32 *SharedBufHints;
+static uint32 SharedBufHintMask;
+
+static uint32 BufTableHintSlots(int size);
+
 
 /*
  * Estimate space needed for mapping hashtable
@@ -42,7 +56,23 @@ static HTAB *SharedBufHash;
 Size
 BufTableShmemSize(int size)
 {
-	return hash_estimate_size(size, sizeof(BufferLookupEnt));
+	Size		result;
+
+	result = hash_estimate_size(size, sizeof(BufferLookupEnt));
+	result = add_size(result, mul_size(BufTableHintSlots(size),
+									   sizeof(pg_atomic_uint32)));
+
+	return result;
+}
+
+/*
+ * Number of lookup hint slots for a hash table of the given size: the
+ * smallest power of 2 that's at least as large.
+ */
+static uint32
+BufTableHintSlots(int size)
+{
+	return ((uint32) 1) << my_log2(size);
 }
 
 /*
@@ -53,6 +83,7 @@ void
 InitBufTable(int size)
 {
 	HASHCTL		info;
+	bool		found;
 
 	/* assume no locking is needed yet */
 
@@ -65,6 +96,21 @@ InitBufTable(int size)
 								  size, size,
 								  &info,
 								  HASH_ELEM | HASH_BLOBS | HASH_PARTITION);
+
+	SharedBufHints = (pg_atomic_uint32 *)
+		ShmemInitStruct("Shared Buffer Lookup Hints",
+						mul_size(BufTableHintSlots(size),
+								 sizeof(pg_atomic_uint32)),
+						&found);
+	SharedBufHintMask = BufTableHintSlots(size) - 1;
+
+	if (!found)
+	{
+		uint32		i;
+
+		for (i = 0; i <= SharedBufHintMask; i++)
+			pg_atomic_init_u32(&SharedBufHints[i], 0);
+	}
 }
 
 /*
@@ -103,9 +149,32 @@ BufTableLookup(BufferTag *tagPtr, uint32 hashcode)
 	if (!result)
 		return -1;
 
+	/* remember it for lock-free lookups of the same tag */
+	pg_atomic_write_u32(&SharedBufHints[hashcode & SharedBufHintMask],
+						(uint32) result->id + 1);
+
 	return result->id;
 }
 
+/*
+ * BufTableLookupHint
+ *		Guess which buffer holds the given tag, without any locking;
+ *		return buffer ID, or -1 if we have no guess
+ *
+ * The result may be stale or belong to another tag with a colliding hash
+ * code, so the caller must pin the buffer and then verify its tag.  A -1
+ * result doesn't mean the tag isn't in the table.
+ */
+int
+BufTableLookupHint(uint32 hashcode)
+{
+	uint32		hint;
+
+	hint = pg_atomic_read_u32(&SharedBufHints[hashcode & SharedBufHintMask]);
+
+	return (int) hint - 1;
+}
+
 /*
  * BufTableInsert
  *		Insert a hashtable entry for given tag and buffer ID,
@@ -137,6 +206,9 @@ BufTableInsert(BufferTag *tagPtr, uint32 hashcode, int buf_id)
 
 	result->id = buf_id;
 
+	pg_atomic_write_u32(&SharedBufHints[hashcode & SharedBufHintMask],
+						(uint32) buf_id + 1);
+
 	return -1;
 }
 
@@ -150,6 +222,7 @@ void
 BufTableDelete(BufferTag *tagPtr, uint32 hashcode)
 {
 	BufferLookupEnt *result;
+	uint32		expected;
 
 	result = (BufferLookupEnt *)
 		hash_search_with_hash_value(SharedBufHash,
@@ -160,4 +233,13 @@ BufTableDelete(BufferTag *tagPtr, uint32 hashcode)
 
 	if (!result)				/* shouldn't happen */
 		elog(ERROR, "shared buffer hash table corrupted");
+
+	/*
+	 * Forget the hint if it points to the deleted entry, so that nobody
+	 * pins the buffer in vain.  If it has been overwritten meanwhile, leave
+	 * it alone.
+	 */
+	expected = (uint32) result->id + 1;
+	pg_atomic_compare_exchange_u32(&SharedBufHints[hashcode & SharedBufHintMask],
+								   &expected, 0);
 }
@@ -67,6 +67,14 @@
 
 #define DROP_RELS_BSEARCH_THRESHOLD		20
 
+/*
+ * When dropping buffers of relations whose size is known, and which are
+ * small compared to shared_buffers, looking up each block in the buffer
+ * mapping table is cheaper than scanning all the buffer headers.  The
+ * threshold is a guess at where the lookups become the more expensive way.
+ */
+#define BUF_DROP_FULL_SCAN_THRESHOLD		(uint64) (NBuffers / 32)
+
 typedef struct PrivateRefCountEntry
 {
 	Buffer		buffer;
@@ -451,6 +459,10 @@ static BufferDesc *BufferAlloc(SMgrRelation smgr,
 			BufferAccessStrategy strategy,
 			bool *foundPtr);
 static void FlushBuffer(BufferDesc *buf, SMgrRelation reln);
+static void FindAndDropRelFileNodeBuffers(RelFileNode rnode,
+							  ForkNumber forkNum,
+							  BlockNumber nForkBlock,
+							  BlockNumber firstDelBlock);
 static void AtProcExit_Buffers(int code, Datum arg);
 static void CheckForBufferLeaks(void);
 static int	rnode_comparator(const void *p1, const void *p2);
@@ -582,6 +594,64 @@ PrefetchBuffer(Relation reln, ForkNumber forkNum, BlockNumber blockNum)
 #endif							/* USE_PREFETCH */
 }
 
+/*
+ * CheckBuffersBeyondEOF -- make sure no buffer holds data for blocks that
+ *		are about to be added to a relation without going through
+ *		shared buffers
+ *
+ * This is the same check ReadBuffer_common makes when P_NEW finds an
+ * existing buffer for the new block.  A zero-filled leftover buffer, from a
+ * read beyond EOF with zero_damaged_pages on, is harmless: the page on disk
+ * will be zeroes too.  A buffer with data in it means the kernel reported a
+ * file size shorter than what we wrote earlier, and zero-extending over it
+ * would lose that data, so complain.
+ *
+ * The caller must hold the relation extension lock.  Temp relations are
+ * never extended this way, so only shared buffers are checked.
+ */
+void
+CheckBuffersBeyondEOF(Relation reln, ForkNumber forkNum,
+					  BlockNumber firstBlock, int nblocks)
+{
+	BlockNumber blockNum;
+
+	Assert(!RelationUsesLocalBuffers(reln));
+
+	for (blockNum = firstBlock; blockNum < firstBlock + nblocks; blockNum++)
+	{
+		BufferTag	tag;
+		uint32		hash;
+		LWLock	   *partitionLock;
+		int			buf_id;
+		bool		hasdata = false;
+
+		INIT_BUFFERTAG(tag, RelationGetSmgr(reln)->smgr_rnode.node,
+					   forkNum, blockNum);
+		hash = BufTableHashCode(&tag);
+		partitionLock = BufMappingPartitionLock(hash);
+
+		LWLockAcquire(partitionLock, LW_SHARED);
+		buf_id = BufTableLookup(&tag, hash);
+		if (buf_id >= 0)
+		{
+			BufferDesc *bufHdr = GetBufferDescriptor(buf_id);
+
+			/* the mapping can't change while we hold the partition lock */
+			if ((pg_atomic_read_u32(&bufHdr->state) & BM_VALID) &&
+				!PageIsNew((Page) BufHdrGetBlock(bufHdr)))
+				hasdata = true;
+		}
+		LWLockRelease(partitionLock);
+
+		if (hasdata)
+			ereport(ERROR,
+					(errmsg("unexpected data beyond EOF in block %u of relation %s",
+							blockNum,
+							relpath(RelationGetSmgr(reln)->smgr_rnode, forkNum)),
+					 errhint("This has been seen to occur with buggy kernels; consider updating your system.")));
+	}
+}
+
 
 /*
  * ReadBuffer -- a shorthand for ReadBufferExtended, for reading from main
@@ -1052,6 +1122,7 @@ BufferAlloc(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
 	BufferDesc *buf;
 	bool		valid;
 	uint32		buf_state;
+	int			usage_count = -1;
 
 	/* create a tag so we can lookup the buffer */
     // 生成BufferTag结构体
@@ -1069,6 +1140,32 @@ BufferAlloc(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
      *      (&MainLWLockArray[BUFFER_MAPPING_LWLOCK_OFFSET
      *      + BufTableHashPartition(hashcode)].lock)
      */
+
+	/*
+	 * First try the lock-free lookup hint.  If it names a buffer that holds
+	 * the block, we can pin it without touching the mapping lock at all.
+	 * Once we hold a pin, nobody can change the buffer's tag, so rechecking
+	 * the tag after pinning is enough to know we got the right buffer.  The
+	 * unlocked precheck merely avoids pinning buffers of other blocks.  If
+	 * anything's amiss, including the page not being valid, fall through to
+	 * the normal locked lookup, which knows how to deal with that.
+	 */
+	buf_id = BufTableLookupHint(newHash);
+	if (buf_id >= 0)
+	{
+		buf = GetBufferDescriptor(buf_id);
+		if (BUFFERTAGS_EQUAL(buf->tag, newTag))
+		{
+			valid = PinBuffer(buf, strategy);
+			if (valid && BUFFERTAGS_EQUAL(buf->tag, newTag))
+			{
+				*foundPtr = true;
+				return buf;
+			}
+			UnpinBuffer(buf, true);
+		}
+	}
+
 	/* see if the block is in the buffer pool already */
 	LWLockAcquire(newPartitionLock, LW_SHARED);// 获取对应分区上的BufMappingLock共享锁
 	buf_id = BufTableLookup(&newTag, newHash);// 找是否有了从buffer_tag-->buffer_id的映射
@@ -1339,6 +1436,14 @@ BufferAlloc(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
 			return buf;
 		}
 
+		/*
+		 * The page is now known to be missing from the buffer pool, so ask
+		 * the replacement policy what usage count it starts with.  Only do
+		 * that once, even if we have to retry with another victim below.
+		 */
+		if (usage_count < 0)
+			usage_count = StrategyInitialUsageCount(strategy, &newTag, newHash);
+
 		/*
 		 * Need to lock the buffer header too in order to change its tag.
 		 */
@@ -1368,8 +1473,9 @@ BufferAlloc(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
 	 *
 	 * Clearing BM_VALID here is necessary, clearing the dirtybits is just
 	 * paranoia.  We also reset the usage_count since any recency of use of
-	 * the old content is no longer relevant.  (The usage_count starts out at
-	 * 1 so that the buffer can survive one clock-sweep pass.)
+	 * the old content is no longer relevant.  (With the default replacement
+	 * policy, the usage_count starts out at 1 so that the buffer can survive
+	 * one clock-sweep pass; see StrategyInitialUsageCount.)
 	 *
 	 * Make sure BM_PERMANENT is set for buffers that must be written at every
 	 * checkpoint.  Unlogged buffers only need to be written at shutdown
@@ -1381,15 +1487,21 @@ BufferAlloc(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
 				   BM_CHECKPOINT_NEEDED | BM_IO_ERROR | BM_PERMANENT |
 				   BUF_USAGECOUNT_MASK);
 	if (relpersistence == RELPERSISTENCE_PERMANENT || forkNum == INIT_FORKNUM)
-		buf_state |= BM_TAG_VALID | BM_PERMANENT | BUF_USAGECOUNT_ONE;
+		buf_state |= BM_TAG_VALID | BM_PERMANENT;
 	else
-		buf_state |= BM_TAG_VALID | BUF_USAGECOUNT_ONE;
+		buf_state |= BM_TAG_VALID;
+	buf_state += usage_count * BUF_USAGECOUNT_ONE;
 
 	UnlockBufHdr(buf, buf_state);
     //【如果老TAG有有效的，需要从哈希表里面删掉】
 	if (oldPartitionLock != NULL)
 	{
 		BufTableDelete(&oldTag, oldHash);
+
+		/* let the replacement policy know the old page was evicted */
+		if (oldFlags & BM_VALID)
+			StrategyRememberEviction(&oldTag, oldHash);
+
 		if (oldPartitionLock != newPartitionLock)
 			LWLockRelease(oldPartitionLock);
 	}
@@ -1566,10 +1678,15 @@ MarkBufferDirty(Buffer buffer)
 	}
 
 	/*
-	 * If the buffer was not dirty already, do vacuum accounting.
+	 * If the buffer was not dirty already, remember where its changes begin
+	 * in the WAL, and do vacuum accounting.  Callers must mark the buffer
+	 * dirty before inserting the WAL record describing the change, so the
+	 * record can't be before the position we see here.
 	 */
 	if (!(old_buf_state & BM_DIRTY))
 	{
+		bufHdr->first_dirty_lsn = GetXLogInsertRecPtr();
+
 		VacuumPageDirty++;
 		pgBufferUsage.shared_blks_dirtied++;
 		if (VacuumCostActive)
@@ -1868,6 +1985,14 @@ UnpinBuffer(BufferDesc *buf, bool fixOwner)
  * CHECKPOINT_END_OF_RECOVERY or CHECKPOINT_FLUSH_ALL is set, we write even
  * unlogged buffers, which are otherwise skipped.  The remaining flags
  * currently have no effect here.
+ *
+ * Except when writing all buffers, we also skip buffers that were first
+ * dirtied after the checkpoint's redo pointer.  All changes made to such a
+ * buffer since it was last written are WAL-logged after the redo pointer,
+ * so recovery from this checkpoint replays them anyway; the buffer is left
+ * for a later checkpoint (or the bgwriter) to write.  This keeps each
+ * checkpoint from writing pages that were dirtied only moments before it
+ * started scanning the pool.
  */
 static void
 BufferSync(int flags)
@@ -1883,6 +2008,7 @@ BufferSync(int flags)
 	binaryheap *ts_heap;
 	int			i;
 	int			mask = BM_DIRTY;
+	XLogRecPtr	redo = InvalidXLogRecPtr;
 	WritebackContext wb_context;
 
 	/* Make sure we can handle the pin inside SyncOneBuffer */
@@ -1890,12 +2016,23 @@ BufferSync(int flags)
 
 	/*
 	 * Unless this is a shutdown checkpoint or we have been explicitly told,
-	 * we write only permanent, dirty buffers.  But at shutdown or end of
-	 * recovery, we write all dirty buffers.
+	 * we write only permanent, dirty buffers, and only those dirtied before
+	 * the redo pointer.  But at shutdown or end of recovery, we write all
+	 * dirty buffers.
+	 *
+	 * first_dirty_lsn is read without a lock that its writer holds, so this
+	 * relies on 8-byte reads not being torn.  During recovery, the WAL
+	 * insert position isn't advancing, so first_dirty_lsn is always older
+	 * than the restartpoint's redo pointer and nothing gets skipped.
 	 */
 	if (!((flags & (CHECKPOINT_IS_SHUTDOWN | CHECKPOINT_END_OF_RECOVERY |
 					CHECKPOINT_FLUSH_ALL))))
+	{
 		mask |= BM_PERMANENT;
+#ifdef PG_HAVE_8BYTE_SINGLE_COPY_ATOMICITY
+		redo = GetRedoRecPtr();
+#endif
+	}
 
 	/*
 	 * Loop over all buffers, and mark the ones that need to be written with
@@ -1924,7 +2061,8 @@ BufferSync(int flags)
 		 */
 		buf_state = LockBufHdr(bufHdr);
 
-		if ((buf_state & mask) == mask)
+		if ((buf_state & mask) == mask &&
+			(XLogRecPtrIsInvalid(redo) || bufHdr->first_dirty_lsn <= redo))
 		{
 			CkptSortItem *item;
 
@@ -2969,16 +3107,19 @@ BufferGetLSNAtomic(Buffer buffer)
  *		that no other process could be trying to load more pages of the
  *		relation into buffers.
  *
- *		XXX currently it sequentially searches the buffer pool, should be
- *		changed to more clever ways of searching.  However, this routine
- *		is used only in code paths that aren't very performance-critical,
- *		and we shouldn't slow down the hot paths to make it faster ...
+ *		If the size of the fork is reliably known (which currently is only
+ *		the case during recovery) and small, we look up each to-be-dropped
+ *		block in the buffer mapping table.  Otherwise we sequentially scan
+ *		the whole buffer pool.  We don't maintain a per-relation index of
+ *		buffers for this, since that would slow down the hot paths.
  * --------------------------------------------------------------------
  */
 void
-DropRelFileNodeBuffers(RelFileNodeBackend rnode, ForkNumber forkNum,
+DropRelFileNodeBuffers(SMgrRelation smgr_reln, ForkNumber forkNum,
 					   BlockNumber firstDelBlock)
 {
+	RelFileNodeBackend rnode = smgr_reln->smgr_rnode;
+	BlockNumber nForkBlock;
 	int			i;
 
 	/* If it's a local relation, it's localbuf.c's problem. */
@@ -2989,6 +3130,23 @@ DropRelFileNodeBuffers(RelFileNodeBackend rnode, ForkNumber forkNum,
 		return;
 	}
 
+	/*
+	 * To remove all the pages of the fork, we need the number of blocks it
+	 * has.  smgrnblocks_cached() only returns a value we can trust to cover
+	 * every buffer of the fork, i.e. none can exist beyond it; see
+	 * smgrnblocks_cached().
+	 */
+	nForkBlock = smgrnblocks_cached(smgr_reln, forkNum);
+
+	if (nForkBlock != InvalidBlockNumber &&
+		(nForkBlock <= firstDelBlock ||
+		 nForkBlock - firstDelBlock < BUF_DROP_FULL_SCAN_THRESHOLD))
+	{
+		FindAndDropRelFileNodeBuffers(rnode.node, forkNum, nForkBlock,
+									  firstDelBlock);
+		return;
+	}
+
 	for (i = 0; i < NBuffers; i++)
 	{
 		BufferDesc *bufHdr = GetBufferDescriptor(i);
@@ -3033,28 +3191,33 @@ DropRelFileNodeBuffers(RelFileNodeBackend rnode, ForkNumber forkNum,
  * --------------------------------------------------------------------
  */
 void
-DropRelFileNodesAllBuffers(RelFileNodeBackend *rnodes, int nnodes)
+DropRelFileNodesAllBuffers(SMgrRelation *smgr_reln, int nnodes)
 {
 	int			i,
+				j,
 				n = 0;
+	SMgrRelation *rels;
+	BlockNumber (*block)[MAX_FORKNUM + 1];
+	uint64		nBlocksToInvalidate = 0;
 	RelFileNode *nodes;
+	bool		cached = true;
 	bool		use_bsearch;
 
 	if (nnodes == 0)
 		return;
 
-	nodes = palloc(sizeof(RelFileNode) * nnodes);	/* non-local relations */
+	rels = palloc(sizeof(SMgrRelation) * nnodes);	/* non-local relations */
 
 	/* If it's a local relation, it's localbuf.c's problem. */
 	for (i = 0; i < nnodes; i++)
 	{
-		if (RelFileNodeBackendIsTemp(rnodes[i]))
+		if (RelFileNodeBackendIsTemp(smgr_reln[i]->smgr_rnode))
 		{
-			if (rnodes[i].backend == MyBackendId)
-				DropRelFileNodeAllLocalBuffers(rnodes[i].node);
+			if (smgr_reln[i]->smgr_rnode.backend == MyBackendId)
+				DropRelFileNodeAllLocalBuffers(smgr_reln[i]->smgr_rnode.node);
 		}
 		else
-			nodes[n++] = rnodes[i].node;
+			rels[n++] = smgr_reln[i];
 	}
 
 	/*
@@ -3063,10 +3226,68 @@ DropRelFileNodesAllBuffers(RelFileNodeBackend *rnodes, int nnodes)
 	 */
 	if (n == 0)
 	{
-		pfree(nodes);
+		pfree(rels);
 		return;
 	}
 
+	/*
+	 * If the sizes of all forks of all the relations are reliably known (see
+	 * DropRelFileNodeBuffers), and they are small in total, look up their
+	 * blocks individually rather than scanning the whole buffer pool.
+	 * Outside recovery the sizes are never known, so don't bother.
+	 */
+	block = (BlockNumber (*)[MAX_FORKNUM + 1])
+		palloc(sizeof(BlockNumber) * n * (MAX_FORKNUM + 1));
+
+	for (i = 0; i < n && cached && InRecovery; i++)
+	{
+		for (j = 0; j <= MAX_FORKNUM; j++)
+		{
+			/* Get the number of blocks for a relation's fork. */
+			block[i][j] = smgrnblocks_cached(rels[i], j);
+
+			/* We need to only consider the relation forks that exists. */
+			if (block[i][j] == InvalidBlockNumber)
+			{
+				if (!smgrexists(rels[i], j))
+					continue;
+				cached = false;
+				break;
+			}
+
+			/* calculate the total number of blocks to be invalidated */
+			nBlocksToInvalidate += block[i][j];
+		}
+	}
+
+	if (InRecovery && cached &&
+		nBlocksToInvalidate < BUF_DROP_FULL_SCAN_THRESHOLD)
+	{
+		for (i = 0; i < n; i++)
+		{
+			for (j = 0; j <= MAX_FORKNUM; j++)
+			{
+				/* ignore relation forks that doesn't exist */
+				if (block[i][j] == InvalidBlockNumber)
+					continue;
+
+				/* drop all the buffers for a particular relation fork */
+				FindAndDropRelFileNodeBuffers(rels[i]->smgr_rnode.node,
+											  j, block[i][j], 0);
+			}
+		}
+
+		pfree(block);
+		pfree(rels);
+		return;
+	}
+
+	pfree(block);
+	nodes = palloc(sizeof(RelFileNode) * n);	/* non-local relations */
+	for (i = 0; i < n; i++)
+		nodes[i] = rels[i]->smgr_rnode.node;
+	pfree(rels);
+
 	/*
 	 * For low number of relations to drop just use a simple walk through, to
 	 * save the bsearch overhead. The threshold to use is rather a guess than
@@ -3124,6 +3345,66 @@ DropRelFileNodesAllBuffers(RelFileNodeBackend *rnodes, int nnodes)
 	pfree(nodes);
 }
 
+/* ---------------------------------------------------------------------
+ *		FindAndDropRelFileNodeBuffers
+ *
+ *		This function performs a lookup in the buffer mapping table for each
+ *		block of the specified relation fork that has a block number >=
+ *		firstDelBlock and < nForkBlock, and removes the buffers found from
+ *		the buffer pool.  The caller must know that no buffer of the fork
+ *		can exist for a block number >= nForkBlock.
+ * --------------------------------------------------------------------
+ */
+static void
+FindAndDropRelFileNodeBuffers(RelFileNode rnode, ForkNumber forkNum,
+							  BlockNumber nForkBlock,
+							  BlockNumber firstDelBlock)
+{
+	BlockNumber curBlock;
+
+	for (curBlock = firstDelBlock; curBlock < nForkBlock; curBlock++)
+	{
+		uint32		bufHash;	/* hash value for tag */
+		BufferTag	bufTag;		/* identity of requested block */
+		LWLock	   *bufPartitionLock;	/* buffer partition lock for it */
+		int			buf_id;
+		BufferDesc *bufHdr;
+		uint32		buf_state;
+
+		/* create a tag so we can lookup the buffer */
+		INIT_BUFFERTAG(bufTag, rnode, forkNum, curBlock);
+
+		/* determine its hash code and partition lock ID */
+		bufHash = BufTableHashCode(&bufTag);
+		bufPartitionLock = BufMappingPartitionLock(bufHash);
+
+		/* Check that it is in the buffer pool. If not, do nothing. */
+		LWLockAcquire(bufPartitionLock, LW_SHARED);
+		buf_id = BufTableLookup(&bufTag, bufHash);
+		LWLockRelease(bufPartitionLock);
+
+		if (buf_id < 0)
+			continue;
+
+		bufHdr = GetBufferDescriptor(buf_id);
+
+		/*
+		 * We need to lock the buffer header and recheck if the buffer is
+		 * still associated with the same block because the buffer could be
+		 * evicted by some other backend loading blocks for some other
+		 * relation after we release the partition lock.
+		 */
+		buf_state = LockBufHdr(bufHdr);
+
+		if (RelFileNodeEquals(bufHdr->tag.rnode, rnode) &&
+			bufHdr->tag.forkNum == forkNum &&
+			bufHdr->tag.blockNum >= firstDelBlock)
+			InvalidateBuffer(bufHdr);	/* releases spinlock */
+		else
+			UnlockBufHdr(bufHdr, buf_state);
+	}
+}
+
 /* ---------------------------------------------------------------------
  *		DropDatabaseBuffers
  *
@@ -3510,6 +3791,7 @@ MarkBufferDirtyHint(Buffer buffer, bool buffer_std)
 		(BM_DIRTY | BM_JUST_DIRTIED))
 	{
 		XLogRecPtr	lsn = InvalidXLogRecPtr;
+		XLogRecPtr	dirty_lsn = InvalidXLogRecPtr;
 		bool		dirtied = false;
 		bool		delayChkpt = false;
 		uint32		buf_state;
@@ -3562,6 +3844,13 @@ MarkBufferDirtyHint(Buffer buffer, bool buffer_std)
 			Assert(!MyPgXact->delayChkpt);
 			MyPgXact->delayChkpt = true;
 			delayChkpt = true;
+
+			/*
+			 * Read the insert position before logging the full page image,
+			 * so that a checkpoint starting in between can't see the buffer
+			 * as dirtied after its redo pointer (see BufferSync).
+			 */
+			dirty_lsn = GetXLogInsertRecPtr();
 			lsn = XLogSaveBufferForHint(buffer, buffer_std);
 		}
 
@@ -3573,6 +3862,18 @@ MarkBufferDirtyHint(Buffer buffer, bool buffer_std)
 		{
 			dirtied = true;		/* Means "will be dirtied by this action" */
 
+			/*
+			 * If we wrote a backup block, the buffer counts as dirtied no
+			 * later than that record, so a checkpoint whose redo pointer
+			 * follows it must still write the page out.
+			 */
+			if (!XLogRecPtrIsInvalid(lsn))
+				bufHdr->first_dirty_lsn = lsn;
+			else if (!XLogRecPtrIsInvalid(dirty_lsn))
+				bufHdr->first_dirty_lsn = dirty_lsn;
+			else
+				bufHdr->first_dirty_lsn = GetXLogInsertRecPtr();
+
 			/*
 			 * Set the page LSN if we wrote a backup block. We aren't supposed
 			 * to set this when only holding a share lock but as long as we
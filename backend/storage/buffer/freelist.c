@@ -22,22 +22,91 @@
 
 #define INT_ACCESS_ONCE(var)	((int)(*((volatile int *)&(var))))
 
+/* GUC variables */
+int			clock_sweep_partitions = 1;
+int			buffer_replacement_policy = BUFFER_REPLACEMENT_CLOCK;
 
 /*
- * The shared freelist control information.
+ * The "2q" replacement policy is an approximation of 2Q on top of the clock
+ * sweep.  2Q keeps newly read pages in a probationary FIFO (A1in), promotes
+ * pages that are referenced again to the main LRU queue (Am), and remembers
+ * the tags of pages recently pushed out of A1in in a ghost queue (A1out);
+ * a miss on a page found in A1out goes straight to Am.
+ *
+ * We don't maintain A1in and Am as separate lists, since the clock sweep,
+ * the background writer and the buffer rings all depend on the single
+ * clock.  Instead a page read into a buffer starts out with a usage count of
+ * zero, so the clock sweep reclaims it on its next pass unless the page is
+ * used again in the meantime (A1in), while reuse bumps the usage count as
+ * usual and keeps the page around (Am).
+ *
+ * A1out is kept exactly: a FIFO of the tags of recently evicted pages,
+ * holding up to half as many tags as there are buffers, with a hash table
+ * to look them up.  Both are split by buffer mapping partition, and all
+ * access to a partition's part is done while holding that partition's
+ * mapping lock in exclusive mode, which BufferAlloc holds anyway when it
+ * evicts a page or confirms a miss.  A page found in A1out when it is read
+ * back in starts with a usage count of GHOST_HIT_USAGE_COUNT.
  */
-typedef struct
+#define GHOST_HIT_USAGE_COUNT	2
+
+typedef struct GhostEntry
 {
-	/* Spinlock: protects the values below */
-	slock_t		buffer_strategy_lock;
+	BufferTag	key;			/* tag of a recently evicted page */
+	int			slot;			/* index of its slot in GhostTags */
+} GhostEntry;
 
+static HTAB *GhostTable = NULL;
+
+/* FIFO slots, GhostQueueSize of them per partition; cleared tag if unused */
+static BufferTag *GhostTags = NULL;
+
+/* next FIFO slot to (re)use, per partition */
+static int *GhostNext = NULL;
+
+/*
+ * The clock sweep can be split into several partitions, each with its own
+ * clock hand, so that backends running the sweep concurrently don't all
+ * hammer the same cache line.  The partitions are interleaved: partition p
+ * consists of the buffers whose buffer id modulo the number of partitions is
+ * p.  Each backend runs the sweep over its own "home" partition, and only
+ * moves on to the others if every buffer in it is pinned.
+ */
+typedef struct
+{
 	/*
-	 * Clock sweep hand: index of next buffer to consider grabbing. Note that
-	 * this isn't a concrete buffer - we only ever increase the value. So, to
-	 * get an actual buffer, it needs to be used modulo NBuffers.
+	 * Clock sweep hand: index of next buffer to consider grabbing, counted
+	 * in buffers of this partition. Note that this isn't a concrete buffer -
+	 * we only ever increase the value. So, to get an actual buffer, it needs
+	 * to be used modulo nbuffers.
 	 */
 	pg_atomic_uint32 nextVictimBuffer;  // 读取nextVictimBuffer是原子操作
 
+	uint32		nbuffers;		/* Number of buffers in this partition */
+
+	/*
+	 * Complete cycles of the clock sweep of this partition; protected by
+	 * buffer_strategy_lock.  This should be wide enough that it can't
+	 * overflow during a single bgwriter cycle.
+	 */
+	uint32		completePasses;
+} ClockSweepPartition;
+
+/* Pad each partition to a full cache line, that's the point of having them */
+typedef union ClockSweepPartitionPadded
+{
+	ClockSweepPartition p;
+	char		pad[PG_CACHE_LINE_SIZE];
+} ClockSweepPartitionPadded;
+
+/*
+ * The shared freelist control information.
+ */
+typedef struct
+{
+	/* Spinlock: protects the values below */
+	slock_t		buffer_strategy_lock;
+
 	int			firstFreeBuffer;	/* Head of list of unused buffers */ // 全局的free list 头部
 	int			lastFreeBuffer; /* Tail of list of unused buffers */ // 全局的free list尾部
 
@@ -50,7 +119,6 @@ typedef struct
 	 * Statistics.  These counters should be wide enough that they can't
 	 * overflow during a single bgwriter cycle.
 	 */
-	uint32		completePasses; /* Complete cycles of the clock sweep */
 	pg_atomic_uint32 numBufferAllocs;	/* Buffers allocated since last reset */
 
 	/*
@@ -58,11 +126,22 @@ typedef struct
 	 * StrategyNotifyBgWriter.
 	 */
 	int			bgwprocno;
+
+	/* Clock sweep partitions; their number doesn't change after startup */
+	int			numPartitions;
+	ClockSweepPartitionPadded partitions[FLEXIBLE_ARRAY_MEMBER];
 } BufferStrategyControl;
 
+#define SizeOfBufferStrategyControl(npartitions) \
+	add_size(offsetof(BufferStrategyControl, partitions), \
+			 mul_size(sizeof(ClockSweepPartitionPadded), (npartitions)))
+
 /* Pointers to shared state */
 static BufferStrategyControl *StrategyControl = NULL;
 
+/* This backend's home clock sweep partition, or -1 if not chosen yet */
+static int	MySweepPartition = -1;
+
 /*
  * Private (non-shared) state for managing a ring of shared buffers to re-use.
  * This is currently the only kind of BufferAccessStrategy object, but someday
@@ -102,16 +181,20 @@ static BufferDesc *GetBufferFromRing(BufferAccessStrategy strategy,
 				  uint32 *buf_state);
 static void AddBufferToRing(BufferAccessStrategy strategy,
 				BufferDesc *buf);
+static int	NumClockSweepPartitions(void);
+static int	GhostQueueSize(void);
 
 /*
  * ClockSweepTick - Helper routine for StrategyGetBuffer()
  *
- * Move the clock hand one buffer ahead of its current position and return the
- * id of the buffer now under the hand.
+ * Move the clock hand of the given partition one buffer ahead of its current
+ * position and return the id of the buffer now under the hand.
  */
 static inline uint32
-ClockSweepTick(void)
+ClockSweepTick(int partno)
 {
+	ClockSweepPartition *part = &StrategyControl->partitions[partno].p;
+	uint32		nbuffers = part->nbuffers;
 	uint32		victim;
 
 	/*
@@ -121,14 +204,14 @@ ClockSweepTick(void)
 	 * 原子式地向前移动一个缓冲区——如果有几个进程这样做，这可能会导致缓冲区的返回稍微不按顺序
 	 */
 	victim =
-		pg_atomic_fetch_add_u32(&StrategyControl->nextVictimBuffer, 1);
+		pg_atomic_fetch_add_u32(&part->nextVictimBuffer, 1);
 
-	if (victim >= NBuffers)
+	if (victim >= nbuffers)
 	{
 		uint32		originalVictim = victim;
 
 		/* always wrap what we look up in BufferDescriptors */
-		victim = victim % NBuffers;
+		victim = victim % nbuffers;
 
 		/*
 		 * If we're the one that just caused a wraparound, force
@@ -156,17 +239,19 @@ ClockSweepTick(void)
 				 */
 				SpinLockAcquire(&StrategyControl->buffer_strategy_lock);
 
-				wrapped = expected % NBuffers;
+				wrapped = expected % nbuffers;
 
-				success = pg_atomic_compare_exchange_u32(&StrategyControl->nextVictimBuffer,
+				success = pg_atomic_compare_exchange_u32(&part->nextVictimBuffer,
 														 &expected, wrapped);
 				if (success)
-					StrategyControl->completePasses++;
+					part->completePasses++;
 				SpinLockRelease(&StrategyControl->buffer_strategy_lock);
 			}
 		}
 	}
-	return victim;
+
+	/* convert position within the partition to a buffer id */
+	return victim * StrategyControl->numPartitions + partno;
 }
 
 /*
@@ -205,6 +290,8 @@ StrategyGetBuffer(BufferAccessStrategy strategy, uint32 *buf_state)
 	BufferDesc *buf;
 	int			bgwprocno;
 	int			trycounter;
+	int			partno;
+	int			partitions_tried;
 	uint32		local_buf_state;	/* to avoid repeated (de-)referencing */
 
 	/*
@@ -314,11 +401,20 @@ StrategyGetBuffer(BufferAccessStrategy strategy, uint32 *buf_state)
 		}
 	}
 
-	/* Nothing on the freelist, so run the "clock sweep" algorithm */
-	trycounter = NBuffers;
+	/*
+	 * Nothing on the freelist, so run the "clock sweep" algorithm, starting
+	 * with our home partition.  Backends are spread over the partitions by
+	 * their PGPROC number, which is stable for the life of the backend.
+	 */
+	if (MySweepPartition < 0)
+		MySweepPartition = (MyProc != NULL ? MyProc->pgprocno : MyProcPid) %
+			StrategyControl->numPartitions;
+	partno = MySweepPartition;
+	partitions_tried = 1;
+	trycounter = StrategyControl->partitions[partno].p.nbuffers;
 	for (;;)
 	{
-		buf = GetBufferDescriptor(ClockSweepTick());
+		buf = GetBufferDescriptor(ClockSweepTick(partno));
 
 		/*
 		 * If the buffer is pinned or has a nonzero usage_count, we cannot use
@@ -332,7 +428,8 @@ StrategyGetBuffer(BufferAccessStrategy strategy, uint32 *buf_state)
 			{
 				local_buf_state -= BUF_USAGECOUNT_ONE;
 
-				trycounter = NBuffers;
+				trycounter = StrategyControl->partitions[partno].p.nbuffers;
+				partitions_tried = 1;
 			}
 			else
 			{
@@ -346,14 +443,21 @@ StrategyGetBuffer(BufferAccessStrategy strategy, uint32 *buf_state)
 		else if (--trycounter == 0)
 		{
 			/*
-			 * We've scanned all the buffers without making any state changes,
-			 * so all the buffers are pinned (or were when we looked at them).
-			 * We could hope that someone will free one eventually, but it's
-			 * probably better to fail than to risk getting stuck in an
-			 * infinite loop.
+			 * We've scanned all the buffers of this partition without making
+			 * any state changes, so they are all pinned (or were when we
+			 * looked at them).  Move on to the next partition.  If we've
+			 * been through all of them, we could hope that someone will free
+			 * one eventually, but it's probably better to fail than to risk
+			 * getting stuck in an infinite loop.
 			 */
-			UnlockBufHdr(buf, local_buf_state);
-			elog(ERROR, "no unpinned buffers available");
+			if (partitions_tried == StrategyControl->numPartitions)
+			{
+				UnlockBufHdr(buf, local_buf_state);
+				elog(ERROR, "no unpinned buffers available");
+			}
+			partno = (partno + 1) % StrategyControl->numPartitions;
+			partitions_tried++;
+			trycounter = StrategyControl->partitions[partno].p.nbuffers;
 		}
 		UnlockBufHdr(buf, local_buf_state);
 	}
@@ -392,27 +496,37 @@ StrategyFreeBuffer(BufferDesc *buf)
  * the higher-order bits of nextVictimBuffer) and the count of recent buffer
  * allocs if non-NULL pointers are passed.  The alloc count is reset after
  * being read.
+ *
+ * With several clock sweep partitions, we report a virtual clock hand that
+ * has advanced by the total number of buffers all the partition hands have
+ * advanced.  As the partitions are interleaved, and the hands advance at
+ * roughly the same rate, the buffers just ahead of that position are the
+ * ones just ahead of each partition's hand.
  */
 int
 StrategySyncStart(uint32 *complete_passes, uint32 *num_buf_alloc)
 {
-	uint32		nextVictimBuffer;
+	uint64		ticks = 0;
 	int			result;
+	int			i;
 
 	SpinLockAcquire(&StrategyControl->buffer_strategy_lock);
-	nextVictimBuffer = pg_atomic_read_u32(&StrategyControl->nextVictimBuffer);
-	result = nextVictimBuffer % NBuffers;
-
-	if (complete_passes)
+	for (i = 0; i < StrategyControl->numPartitions; i++)
 	{
-		*complete_passes = StrategyControl->completePasses;
+		ClockSweepPartition *part = &StrategyControl->partitions[i].p;
 
 		/*
-		 * Additionally add the number of wraparounds that happened before
-		 * completePasses could be incremented. C.f. ClockSweepTick().
+		 * nextVictimBuffer can be beyond nbuffers if the wraparound hasn't
+		 * been accounted for in completePasses yet, c.f. ClockSweepTick(),
+		 * but that works out the same here.
 		 */
-		*complete_passes += nextVictimBuffer / NBuffers;
+		ticks += (uint64) part->completePasses * part->nbuffers +
+			pg_atomic_read_u32(&part->nextVictimBuffer);
 	}
+	result = (int) (ticks % NBuffers);
+
+	if (complete_passes)
+		*complete_passes = (uint32) (ticks / NBuffers);
 
 	if (num_buf_alloc)
 	{
@@ -444,6 +558,118 @@ StrategyNotifyBgWriter(int bgwprocno)
 }
 
 
+/*
+ * StrategyRememberEviction -- note that a valid page has been evicted
+ *
+ * tag and hashcode identify the evicted page.  The caller must hold the
+ * page's buffer mapping partition lock in exclusive mode.
+ */
+void
+StrategyRememberEviction(BufferTag *tag, uint32 hashcode)
+{
+	int			partition;
+	int			slot;
+	BufferTag  *slottag;
+	GhostEntry *entry;
+	bool		found;
+
+	if (GhostTable == NULL)
+		return;
+
+	Assert(LWLockHeldByMeInMode(BufMappingPartitionLock(hashcode),
+								LW_EXCLUSIVE));
+
+	partition = BufTableHashPartition(hashcode);
+	slot = partition * GhostQueueSize() + GhostNext[partition];
+	slottag = &GhostTags[slot];
+
+	/*
+	 * If the slot is in use, push its tag out of the queue.  The tag is in
+	 * our partition, since it was put there by this function.  The hash
+	 * entry may have been consumed by a ghost hit, or moved to a later slot
+	 * if the page was evicted again, in which case we leave it alone.
+	 */
+	if (slottag->blockNum != InvalidBlockNumber)
+	{
+		uint32		oldhash = get_hash_value(GhostTable, slottag);
+
+		entry = (GhostEntry *)
+			hash_search_with_hash_value(GhostTable, slottag, oldhash,
+										HASH_FIND, NULL);
+		if (entry != NULL && entry->slot == slot)
+			hash_search_with_hash_value(GhostTable, slottag, oldhash,
+										HASH_REMOVE, NULL);
+	}
+
+	entry = (GhostEntry *)
+		hash_search_with_hash_value(GhostTable, tag, hashcode,
+									HASH_ENTER_NULL, &found);
+	if (entry != NULL)
+	{
+		entry->slot = slot;
+		*slottag = *tag;
+	}
+	else
+		CLEAR_BUFFERTAG(*slottag);
+
+	GhostNext[partition] = (GhostNext[partition] + 1) % GhostQueueSize();
+}
+
+/*
+ * StrategyInitialUsageCount -- usage count for a page being read in
+ *
+ * tag and hashcode identify the page, strategy is the access strategy it is
+ * read with.  This must only be called once the page is known not to be in
+ * the buffer pool, that is after its buffer table entry has been made, and
+ * with the page's buffer mapping partition lock held in exclusive mode.  A
+ * ghost entry found for the page is consumed.
+ *
+ * Pages read through a ring buffer are never considered ghost hits, as the
+ * ring takes care of them anyway.
+ */
+uint32
+StrategyInitialUsageCount(BufferAccessStrategy strategy, BufferTag *tag,
+						  uint32 hashcode)
+{
+	bool		found;
+
+	if (buffer_replacement_policy == BUFFER_REPLACEMENT_CLOCK)
+		return 1;
+
+	if (strategy != NULL || GhostTable == NULL)
+		return 0;
+
+	Assert(LWLockHeldByMeInMode(BufMappingPartitionLock(hashcode),
+								LW_EXCLUSIVE));
+
+	hash_search_with_hash_value(GhostTable, tag, hashcode,
+								HASH_REMOVE, &found);
+
+	return found ? GHOST_HIT_USAGE_COUNT : 0;
+}
+
+/*
+ * GhostQueueSize -- per-partition size of the 2Q ghost queue, 0 if unused
+ */
+static int
+GhostQueueSize(void)
+{
+	if (buffer_replacement_policy != BUFFER_REPLACEMENT_2Q)
+		return 0;
+	return Max(NBuffers / (2 * NUM_BUFFER_PARTITIONS), 1);
+}
+
+/*
+ * NumClockSweepPartitions -- number of clock sweep partitions to use
+ *
+ * Every partition needs at least one buffer.
+ */
+static int
+NumClockSweepPartitions(void)
+{
+	return Min(clock_sweep_partitions, NBuffers);
+}
+
 /*
  * StrategyShmemSize
  *
@@ -461,7 +687,18 @@ StrategyShmemSize(void)
 	size = add_size(size, BufTableShmemSize(NBuffers + NUM_BUFFER_PARTITIONS));
 
 	/* size of the shared replacement strategy control block */
-	size = add_size(size, MAXALIGN(sizeof(BufferStrategyControl)));
+	size = add_size(size,
+					MAXALIGN(SizeOfBufferStrategyControl(NumClockSweepPartitions())));
+
+	/* size of the ghost queue, if any */
+	if (GhostQueueSize() > 0)
+	{
+		int			nghosts = GhostQueueSize() * NUM_BUFFER_PARTITIONS;
+
+		size = add_size(size, hash_estimate_size(nghosts, sizeof(GhostEntry)));
+		size = add_size(size, mul_size(nghosts, sizeof(BufferTag)));
+		size = add_size(size, mul_size(NUM_BUFFER_PARTITIONS, sizeof(int)));
+	}
 
 	return size;
 }
@@ -495,11 +732,14 @@ StrategyInitialize(bool init)
 	 */
 	StrategyControl = (BufferStrategyControl *)
 		ShmemInitStruct("Buffer Strategy Status",
-						sizeof(BufferStrategyControl),
+						SizeOfBufferStrategyControl(NumClockSweepPartitions()),
 						&found);
 
 	if (!found)
 	{
+		int			npartitions = NumClockSweepPartitions();
+		int			i;
+
 		/*
 		 * Only done once, usually in postmaster
 		 */
@@ -514,11 +754,21 @@ StrategyInitialize(bool init)
 		StrategyControl->firstFreeBuffer = 0;
 		StrategyControl->lastFreeBuffer = NBuffers - 1;
 
-		/* Initialize the clock sweep pointer */
-		pg_atomic_init_u32(&StrategyControl->nextVictimBuffer, 0);
+		/*
+		 * Initialize the clock sweep pointers.  Partition i gets the buffers
+		 * i, i + npartitions, i + 2 * npartitions and so on.
+		 */
+		StrategyControl->numPartitions = npartitions;
+		for (i = 0; i < npartitions; i++)
+		{
+			ClockSweepPartition *part = &StrategyControl->partitions[i].p;
+
+			pg_atomic_init_u32(&part->nextVictimBuffer, 0);
+			part->nbuffers = (NBuffers - i + npartitions - 1) / npartitions;
+			part->completePasses = 0;
+		}
 
 		/* Clear statistics */
-		StrategyControl->completePasses = 0;
 		pg_atomic_init_u32(&StrategyControl->numBufferAllocs, 0);
 
 		/* No pending notification */
@@ -526,6 +776,43 @@ StrategyInitialize(bool init)
 	}
 	else
 		Assert(!init);
+
+	/*
+	 * Get or create the ghost queue
+	 */
+	if (GhostQueueSize() > 0)
+	{
+		int			nghosts = GhostQueueSize() * NUM_BUFFER_PARTITIONS;
+		HASHCTL		info;
+
+		info.keysize = sizeof(BufferTag);
+		info.entrysize = sizeof(GhostEntry);
+		info.num_partitions = NUM_BUFFER_PARTITIONS;
+
+		GhostTable = ShmemInitHash("Buffer Ghost Table",
+								   nghosts, nghosts,
+								   &info,
+								   HASH_ELEM | HASH_BLOBS | HASH_PARTITION);
+
+		GhostTags = (BufferTag *)
+			ShmemInitStruct("Buffer Ghost Queue",
+							mul_size(nghosts, sizeof(BufferTag)),
+							&found);
+		GhostNext = (int *)
+			ShmemInitStruct("Buffer Ghost Queue Heads",
+							mul_size(NUM_BUFFER_PARTITIONS, sizeof(int)),
+							&found);
+
+		if (!found)
+		{
+			int			i;
+
+			for (i = 0; i < nghosts; i++)
+				CLEAR_BUFFERTAG(GhostTags[i]);
+			for (i = 0; i < NUM_BUFFER_PARTITIONS; i++)
+				GhostNext[i] = 0;
+		}
+	}
 }
 
 
@@ -2103,6 +2103,94 @@ retry:
 	return returnCode;
 }
 
+/*
+ * Extend a file by writing "amount" bytes of zeroes at "offset".
+ *
+ * Returns 0 on success, or -1 with errno set on failure.  A short write is
+ * reported as ENOSPC, as in FileWrite().
+ */
+int
+FileZero(File file, off_t offset, off_t amount, uint32 wait_event_info)
+{
+	static const PGAlignedBlock zbuffer = {{0}};
+	off_t		remaining = amount;
+
+	Assert(FileIsValid(file));
+
+	DO_DB(elog(LOG, "FileZero: %d (%s) " INT64_FORMAT " " INT64_FORMAT,
+			   file, VfdCache[file].fileName,
+			   (int64) offset, (int64) amount));
+
+	if (FileSeek(file, offset, SEEK_SET) != offset)
+		return -1;
+
+	while (remaining > 0)
+	{
+		int			chunk = (int) Min(remaining, (off_t) BLCKSZ);
+		int			returnCode;
+
+		returnCode = FileWrite(file, (char *) zbuffer.data, chunk,
+							   wait_event_info);
+		if (returnCode < 0)
+			return -1;
+		if (returnCode != chunk)
+		{
+			/* short write: assume the disk is full, as FileWrite does */
+			errno = ENOSPC;
+			return -1;
+		}
+		remaining -= chunk;
+	}
+
+	return 0;
+}
+
+/*
+ * Extend a file by "amount" bytes at "offset" without writing the data
+ * ourselves.
+ *
+ * Where posix_fallocate() is available we let the filesystem reserve the
+ * space in a single call, which is much cheaper than writing zeroes page by
+ * page for large extensions.  If the filesystem does not support it, we fall
+ * back to FileZero().  Returns 0 on success, or -1 with errno set.
+ */
+int
+FileFallocate(File file, off_t offset, off_t amount, uint32 wait_event_info)
+{
+#ifdef HAVE_POSIX_FALLOCATE
+	int			returnCode;
+
+	Assert(FileIsValid(file));
+
+	DO_DB(elog(LOG, "FileFallocate: %d (%s) " INT64_FORMAT " " INT64_FORMAT,
+			   file, VfdCache[file].fileName,
+			   (int64) offset, (int64) amount));
+
+	returnCode = FileAccess(file);
+	if (returnCode < 0)
+		return -1;
+
+retry:
+	pgstat_report_wait_start(wait_event_info);
+	returnCode = posix_fallocate(VfdCache[file].fd, offset, amount);
+	pgstat_report_wait_end();
+
+	if (returnCode == 0)
+		return 0;
+	if (returnCode == EINTR)
+		goto retry;
+
+	/* posix_fallocate() reports errors in its result, not in errno */
+	errno = returnCode;
+
+	/* Give up on real failures; fall back if it's just not supported */
+	if (returnCode != EINVAL && returnCode != EOPNOTSUPP)
+		return -1;
+#endif
+
+	return FileZero(file, offset, amount, wait_event_info);
+}
+
 int
 FileSync(File file, uint32 wait_event_info)
 {
@@ -130,6 +130,7 @@ CreateSharedMemoryAndSemaphores(int port)
 		size = add_size(size, BackgroundWorkerShmemSize());
 		size = add_size(size, MultiXactShmemSize());
 		size = add_size(size, LWLockShmemSize());
+		size = add_size(size, LWLockStatsShmemSize());
 		size = add_size(size, ProcArrayShmemSize());
 		size = add_size(size, BackendStatusShmemSize());
 		size = add_size(size, SInvalShmemSize());
@@ -235,6 +236,7 @@ CreateSharedMemoryAndSemaphores(int port)
 		InitProcGlobal();
 	CreateSharedProcArray();
 	CreateSharedBackendStatus();
+	LWLockStatsShmemInit();
 	TwoPhaseShmemInit();
 	BackgroundWorkerShmemInit();
 
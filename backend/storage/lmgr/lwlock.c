@@ -76,9 +76,11 @@
  */
 #include "postgres.h"
 
+#include "access/twophase.h"
 #include "miscadmin.h"
 #include "pgstat.h"
 #include "pg_trace.h"
+#include "portability/instr_time.h"
 #include "postmaster/postmaster.h"
 #include "replication/slot.h"
 #include "storage/ipc.h"
@@ -157,6 +159,41 @@ NamedLWLockTranche *NamedLWLockTrancheArray = NULL;
 
 static bool lock_named_request_allowed = true;
 
+/*
+ * Per-backend wait statistics, see LWLockTrancheStats.  LWLockStatsArray
+ * points to the shared array holding one block of LWLOCK_STATS_NUM_TRANCHES
+ * entries per PGPROC; MyLWLockStats to this backend's block.  Processes
+ * without a PGPROC count into a local dummy entry instead.
+ */
+static LWLockTrancheStats *LWLockStatsArray = NULL;
+static LWLockTrancheStats *MyLWLockStats = NULL;
+static LWLockTrancheStats LWLockStatsDummy;
+
+static inline LWLockTrancheStats *
+LWLockGetTrancheStats(LWLock *lock)
+{
+	if (likely(MyLWLockStats != NULL) &&
+		lock->tranche < LWLOCK_STATS_NUM_TRANCHES)
+		return &MyLWLockStats[lock->tranche];
+	return &LWLockStatsDummy;
+}
+
+/*
+ * Before going to sleep on its semaphore, a waiter first spins for a while
+ * on its own PGPROC's lwWaiting flag, which only the waker touches.  Unlike
+ * spinning on the lock word, that doesn't bounce any shared cache line
+ * between the waiters, and if the lock is handed over quickly it saves the
+ * kernel round trips of a semaphore sleep and wakeup.  The number of spins
+ * is adapted per process the same way s_lock.c adapts spins_per_delay:
+ * increased rapidly when spinning paid off, decreased slowly when it didn't,
+ * so that on a uniprocessor we quickly stop wasting cycles on it.
+ */
+#define MIN_LWLOCK_WAIT_SPINS		10
+#define MAX_LWLOCK_WAIT_SPINS		1000
+#define DEFAULT_LWLOCK_WAIT_SPINS	100
+
+static int	lwlock_wait_spins = DEFAULT_LWLOCK_WAIT_SPINS;
+
 static void InitializeLWLocks(void);
 static void RegisterLWLockTranches(void);
 
@@ -538,6 +575,91 @@ InitLWLockAccess(void)
 #ifdef LWLOCK_STATS
 	init_lwlock_stats();
 #endif
+
+	/*
+	 * Statistics slots are indexed by pgprocno.  Counters are deliberately
+	 * not reset here: whoever used this PGPROC before us contributed to the
+	 * same cumulative totals.
+	 */
+	if (LWLockStatsArray != NULL && MyProc != NULL)
+		MyLWLockStats = LWLockStatsArray +
+			(Size) MyProc->pgprocno * LWLOCK_STATS_NUM_TRANCHES;
+}
+
+/*
+ * Number of PGPROC-indexed slots in the LWLock statistics array; this
+ * matches the number of PGPROCs allocated by InitProcGlobal.
+ */
+static Size
+LWLockStatsNumSlots(void)
+{
+	Size		nslots;
+
+	nslots = add_size(MaxBackends, NUM_AUXILIARY_PROCS);
+	nslots = add_size(nslots, max_prepared_xacts);
+
+	return nslots;
+}
+
+/*
+ * LWLockStatsShmemSize --- report amount of shared memory needed for the
+ * LWLock wait statistics
+ */
+Size
+LWLockStatsShmemSize(void)
+{
+	return mul_size(LWLockStatsNumSlots(),
+					mul_size(LWLOCK_STATS_NUM_TRANCHES,
+							 sizeof(LWLockTrancheStats)));
+}
+
+/*
+ * LWLockStatsShmemInit --- allocate and initialize the LWLock wait statistics
+ */
+void
+LWLockStatsShmemInit(void)
+{
+	bool		found;
+
+	LWLockStatsArray = (LWLockTrancheStats *)
+		ShmemInitStruct("LWLock Statistics", LWLockStatsShmemSize(), &found);
+
+	if (!found)
+		MemSet(LWLockStatsArray, 0, LWLockStatsShmemSize());
+}
+
+/*
+ * LWLockCollectTrancheStats --- add up the wait statistics of all backends
+ *
+ * result must have room for LWLOCK_STATS_NUM_TRANCHES entries.  The counters
+ * are read without any locking, so the totals are only approximately
+ * consistent with each other, which is fine for monitoring purposes.
+ */
+void
+LWLockCollectTrancheStats(LWLockTrancheStats *result)
+{
+	Size		nslots = LWLockStatsNumSlots();
+	Size		slot;
+	int			i;
+
+	MemSet(result, 0, LWLOCK_STATS_NUM_TRANCHES * sizeof(LWLockTrancheStats));
+
+	if (LWLockStatsArray == NULL)
+		return;
+
+	for (slot = 0; slot < nslots; slot++)
+	{
+		volatile LWLockTrancheStats *stats;
+
+		stats = LWLockStatsArray + slot * LWLOCK_STATS_NUM_TRANCHES;
+		for (i = 0; i < LWLOCK_STATS_NUM_TRANCHES; i++)
+		{
+			result[i].acquire_count += stats[i].acquire_count;
+			result[i].block_count += stats[i].block_count;
+			result[i].wait_time += stats[i].wait_time;
+			result[i].spin_delay_count += stats[i].spin_delay_count;
+		}
+	}
 }
 
 /*
@@ -839,6 +961,7 @@ LWLockWaitListLock(LWLock *lock)
 #ifdef LWLOCK_STATS
 			delays += delayStatus.delays;
 #endif
+			LWLockGetTrancheStats(lock)->spin_delay_count += delayStatus.delays;
 			finish_spin_delay(&delayStatus);
 		}
 
@@ -853,6 +976,52 @@ LWLockWaitListLock(LWLock *lock)
 #endif
 }
 
+/*
+ * Wait until we've been removed from the lock's wait queue by a waker.
+ *
+ * Returns the number of extra semaphore wakeups absorbed, which the caller
+ * must give back once it is done waiting.  It is possible that we get
+ * awakened for a reason other than being signaled by LWLockRelease, so keep
+ * sleeping until lwWaiting has been cleared.
+ */
+static int
+LWLockSleep(PGPROC *proc)
+{
+	int			extraWaits = 0;
+	int			spins;
+
+	for (spins = 0; spins < lwlock_wait_spins; spins++)
+	{
+		if (!((volatile PGPROC *) proc)->lwWaiting)
+			break;
+		pg_spin_delay();
+	}
+
+	if (spins < lwlock_wait_spins)
+	{
+		/* woken while spinning; spin a bit longer next time */
+		lwlock_wait_spins = Min(lwlock_wait_spins + 100,
+								MAX_LWLOCK_WAIT_SPINS);
+	}
+	else if (lwlock_wait_spins > MIN_LWLOCK_WAIT_SPINS)
+		lwlock_wait_spins--;
+
+	/*
+	 * Even if we saw lwWaiting cleared, the waker posts our semaphore right
+	 * afterwards, so we have to consume that wakeup.  The semaphore is most
+	 * likely already posted, in which case this doesn't block.
+	 */
+	for (;;)
+	{
+		PGSemaphoreLock(proc->sem);
+		if (!proc->lwWaiting)
+			break;
+		extraWaits++;
+	}
+
+	return extraWaits;
+}
+
 /*
  * Unlock the LWLock's wait list.
  *
@@ -1124,6 +1293,7 @@ LWLockAcquire(LWLock *lock, LWLockMode mode)
 	PGPROC	   *proc = MyProc;
 	bool		result = true;
 	int			extraWaits = 0;
+	LWLockTrancheStats *stats = LWLockGetTrancheStats(lock);
 #ifdef LWLOCK_STATS
 	lwlock_stats *lwstats;
 
@@ -1179,6 +1349,8 @@ LWLockAcquire(LWLock *lock, LWLockMode mode)
 	for (;;)
 	{
 		bool		mustwait;
+		instr_time	waitStart;
+		instr_time	waitTime;
 
 		/*
 		 * Try to grab the lock the first time, we're not in the waitqueue
@@ -1231,17 +1403,17 @@ LWLockAcquire(LWLock *lock, LWLockMode mode)
 #ifdef LWLOCK_STATS
 		lwstats->block_count++;
 #endif
+		stats->block_count++;
 
 		LWLockReportWaitStart(lock);
 		TRACE_POSTGRESQL_LWLOCK_WAIT_START(T_NAME(lock), mode);
+		INSTR_TIME_SET_CURRENT(waitStart);
 
-		for (;;)
-		{
-			PGSemaphoreLock(proc->sem);
-			if (!proc->lwWaiting)
-				break;
-			extraWaits++;
-		}
+		extraWaits += LWLockSleep(proc);
+
+		INSTR_TIME_SET_CURRENT(waitTime);
+		INSTR_TIME_SUBTRACT(waitTime, waitStart);
+		stats->wait_time += INSTR_TIME_GET_MICROSEC(waitTime);
 
 		/* Retrying, allow LWLockRelease to release waiters again. */
 		pg_atomic_fetch_or_u32(&lock->state, LW_FLAG_RELEASE_OK);
@@ -1265,6 +1437,7 @@ LWLockAcquire(LWLock *lock, LWLockMode mode)
 	}
 
 	TRACE_POSTGRESQL_LWLOCK_ACQUIRE(T_NAME(lock), mode);
+	stats->acquire_count++;
 
 	/* Add lock to list of locks held by this backend */
 	held_lwlocks[num_held_lwlocks].lock = lock;
@@ -1323,6 +1496,7 @@ LWLockConditionalAcquire(LWLock *lock, LWLockMode mode)
 		held_lwlocks[num_held_lwlocks].lock = lock;
 		held_lwlocks[num_held_lwlocks++].mode = mode;
 		TRACE_POSTGRESQL_LWLOCK_CONDACQUIRE(T_NAME(lock), mode);
+		LWLockGetTrancheStats(lock)->acquire_count++;
 	}
 	return !mustwait;
 }
@@ -1347,6 +1521,9 @@ LWLockAcquireOrWait(LWLock *lock, LWLockMode mode)
 	PGPROC	   *proc = MyProc;
 	bool		mustwait;
 	int			extraWaits = 0;
+	LWLockTrancheStats *stats = LWLockGetTrancheStats(lock);
+	instr_time	waitStart;
+	instr_time	waitTime;
 #ifdef LWLOCK_STATS
 	lwlock_stats *lwstats;
 
@@ -1391,17 +1568,17 @@ LWLockAcquireOrWait(LWLock *lock, LWLockMode mode)
 #ifdef LWLOCK_STATS
 			lwstats->block_count++;
 #endif
+			stats->block_count++;
 
 			LWLockReportWaitStart(lock);
 			TRACE_POSTGRESQL_LWLOCK_WAIT_START(T_NAME(lock), mode);
+			INSTR_TIME_SET_CURRENT(waitStart);
 
-			for (;;)
-			{
-				PGSemaphoreLock(proc->sem);
-				if (!proc->lwWaiting)
-					break;
-				extraWaits++;
-			}
+			extraWaits += LWLockSleep(proc);
+
+			INSTR_TIME_SET_CURRENT(waitTime);
+			INSTR_TIME_SUBTRACT(waitTime, waitStart);
+			stats->wait_time += INSTR_TIME_GET_MICROSEC(waitTime);
 
 #ifdef LOCK_DEBUG
 			{
@@ -1450,6 +1627,7 @@ LWLockAcquireOrWait(LWLock *lock, LWLockMode mode)
 		held_lwlocks[num_held_lwlocks].lock = lock;
 		held_lwlocks[num_held_lwlocks++].mode = mode;
 		TRACE_POSTGRESQL_LWLOCK_ACQUIRE_OR_WAIT(T_NAME(lock), mode);
+		stats->acquire_count++;
 	}
 
 	return !mustwait;
@@ -1530,6 +1708,7 @@ LWLockWaitForVar(LWLock *lock, uint64 *valptr, uint64 oldval, uint64 *newval)
 	PGPROC	   *proc = MyProc;
 	int			extraWaits = 0;
 	bool		result = false;
+	LWLockTrancheStats *stats = LWLockGetTrancheStats(lock);
 #ifdef LWLOCK_STATS
 	lwlock_stats *lwstats;
 
@@ -1551,6 +1730,8 @@ LWLockWaitForVar(LWLock *lock, uint64 *valptr, uint64 oldval, uint64 *newval)
 	for (;;)
 	{
 		bool		mustwait;
+		instr_time	waitStart;
+		instr_time	waitTime;
 
 		mustwait = LWLockConflictsWithVar(lock, valptr, oldval, newval,
 										  &result);
@@ -1603,17 +1784,17 @@ LWLockWaitForVar(LWLock *lock, uint64 *valptr, uint64 oldval, uint64 *newval)
 #ifdef LWLOCK_STATS
 		lwstats->block_count++;
 #endif
+		stats->block_count++;
 
 		LWLockReportWaitStart(lock);
 		TRACE_POSTGRESQL_LWLOCK_WAIT_START(T_NAME(lock), LW_EXCLUSIVE);
+		INSTR_TIME_SET_CURRENT(waitStart);
 
-		for (;;)
-		{
-			PGSemaphoreLock(proc->sem);
-			if (!proc->lwWaiting)
-				break;
-			extraWaits++;
-		}
+		extraWaits += LWLockSleep(proc);
+
+		INSTR_TIME_SET_CURRENT(waitTime);
+		INSTR_TIME_SUBTRACT(waitTime, waitStart);
+		stats->wait_time += INSTR_TIME_GET_MICROSEC(waitTime);
 
 #ifdef LOCK_DEBUG
 		{
@@ -61,6 +61,7 @@ int			DeadlockTimeout = 1000;
 int			StatementTimeout = 0;
 int			LockTimeout = 0;
 int			IdleInTransactionSessionTimeout = 0;
+int			IdleSessionTimeout = 0;
 bool		log_lock_waits = false;
 
 /* Pointer to this process's PGPROC and PGXACT structs, if any */
@@ -93,6 +94,7 @@ static void RemoveProcFromArray(int code, Datum arg);
 static void ProcKill(int code, Datum arg);
 static void AuxiliaryProcKill(int code, Datum arg);
 static void CheckDeadLock(void);
+static Size FastPathLockShmemSize(void);
 
 
 /*
@@ -118,6 +120,36 @@ ProcGlobalShmemSize(void)
 	size = add_size(size, mul_size(NUM_AUXILIARY_PROCS, sizeof(PGXACT)));
 	size = add_size(size, mul_size(max_prepared_xacts, sizeof(PGXACT)));
 
+	/* fast-path lock arrays */
+	size = add_size(size, FastPathLockShmemSize());
+
+	return size;
+}
+
+/*
+ * Report shared-memory space needed by the fast-path lock arrays of all
+ * PGPROCs.
+ */
+static Size
+FastPathLockShmemSize(void)
+{
+	Size		size = 0;
+	Size		TotalProcs;
+	Size		fpLockBitsSize,
+				fpRelIdSize;
+
+	TotalProcs = add_size(MaxBackends, NUM_AUXILIARY_PROCS);
+	TotalProcs = add_size(TotalProcs, max_prepared_xacts);
+
+	/*
+	 * Memory needed for PGPROC fast-path lock arrays.  Make sure the sizes
+	 * are nicely aligned in each backend.
+	 */
+	fpLockBitsSize = MAXALIGN(FastPathLockGroupsPerBackend * sizeof(uint64));
+	fpRelIdSize = MAXALIGN(FastPathLockSlotsPerBackend() * sizeof(Oid));
+
+	size = add_size(size, mul_size(TotalProcs, (fpLockBitsSize + fpRelIdSize)));
+
 	return size;
 }
 
@@ -168,6 +200,12 @@ InitProcGlobal(void)
 	bool		found;
 	uint32		TotalProcs = MaxBackends + NUM_AUXILIARY_PROCS + max_prepared_xacts;
 
+	/* Used for setup of per-backend fast-path slots. */
+	char	   *fpPtr,
+			   *fpEndPtr PG_USED_FOR_ASSERTS_ONLY;
+	Size		fpLockBitsSize,
+				fpRelIdSize;
+
 	/* Create the ProcGlobal shared structure */
 	ProcGlobal = (PROC_HDR *)
 		ShmemInitStruct("Proc Header", sizeof(PROC_HDR), &found);
@@ -214,10 +252,33 @@ InitProcGlobal(void)
 	MemSet(pgxacts, 0, TotalProcs * sizeof(PGXACT));
 	ProcGlobal->allPgXact = pgxacts;
 
+	/*
+	 * Allocate arrays for fast-path locks.  Those are variable-length, so
+	 * can't be included in PGPROC directly.  We allocate a single chunk of
+	 * memory for all of them, and hand out pieces to each PGPROC below.
+	 */
+	fpLockBitsSize = MAXALIGN(FastPathLockGroupsPerBackend * sizeof(uint64));
+	fpRelIdSize = MAXALIGN(FastPathLockSlotsPerBackend() * sizeof(Oid));
+
+	fpPtr = ShmemAlloc(FastPathLockShmemSize());
+	MemSet(fpPtr, 0, FastPathLockShmemSize());
+
+	/* For asserts checking we did not overflow. */
+	fpEndPtr = fpPtr + FastPathLockShmemSize();
+
 	for (i = 0; i < TotalProcs; i++)
 	{
 		/* Common initialization for all PGPROCs, regardless of type. */
 
+		/* Set the fast-path lock arrays, and move the pointer. */
+		procs[i].fpLockBits = (uint64 *) fpPtr;
+		fpPtr += fpLockBitsSize;
+
+		procs[i].fpRelId = (Oid *) fpPtr;
+		fpPtr += fpRelIdSize;
+
+		Assert(fpPtr <= fpEndPtr);
+
 		/*
 		 * Set up per-PGPROC semaphore, latch, and backendLock. Prepared xact
 		 * dummy PGPROCs don't need these though - they're never associated
@@ -276,6 +337,9 @@ InitProcGlobal(void)
 		pg_atomic_init_u32(&(procs[i].clogGroupNext), INVALID_PGPROCNO);
 	}
 
+	/* Should have consumed exactly the expected amount of fast-path memory. */
+	Assert(fpPtr == fpEndPtr);
+
 	/*
 	 * Save pointers to the blocks of PGPROC structures reserved for auxiliary
 	 * processes and prepared transactions.
@@ -603,6 +667,9 @@ InitAuxiliaryProcess(void)
 	 * Arrange to clean up at process exit.
 	 */
 	on_shmem_exit(AuxiliaryProcKill, Int32GetDatum(proctype));
+
+	/* Initialize local state needed for LWLocks, as in InitProcess */
+	InitLWLockAccess();
 }
 
 /*
@@ -15,6 +15,7 @@
 #include "postgres.h"
 
 #include "access/htup_details.h"
+#include "access/slru.h"
 #include "catalog/pg_authid.h"
 #include "catalog/pg_type.h"
 #include "common/ip.h"
@@ -23,6 +24,7 @@
 #include "pgstat.h"
 #include "postmaster/bgworker_internals.h"
 #include "postmaster/postmaster.h"
+#include "storage/lwlock.h"
 #include "storage/proc.h"
 #include "storage/procarray.h"
 #include "utils/acl.h"
@@ -537,6 +539,144 @@ pg_stat_get_progress_info(PG_FUNCTION_ARGS)
 	return (Datum) 0;
 }
 
+/*
+ * Returns the cumulative LWLock wait statistics, one row per tranche.
+ */
+Datum
+pg_stat_get_lwlocks(PG_FUNCTION_ARGS)
+{
+#define PG_STAT_GET_LWLOCKS_COLS	6
+	TupleDesc	tupdesc;
+	Tuplestorestate *tupstore;
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	MemoryContext per_query_ctx;
+	MemoryContext oldcontext;
+	LWLockTrancheStats *stats;
+	int			i;
+
+	/* check to see if caller supports us returning a tuplestore */
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("materialize mode required, but it is not " \
+						"allowed in this context")));
+
+	/* Build a tuple descriptor for our result type */
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+	MemoryContextSwitchTo(oldcontext);
+
+	stats = (LWLockTrancheStats *)
+		palloc(LWLOCK_STATS_NUM_TRANCHES * sizeof(LWLockTrancheStats));
+	LWLockCollectTrancheStats(stats);
+
+	for (i = 0; i < LWLOCK_STATS_NUM_TRANCHES; i++)
+	{
+		Datum		values[PG_STAT_GET_LWLOCKS_COLS];
+		bool		nulls[PG_STAT_GET_LWLOCKS_COLS];
+
+		/* Don't bother reporting unused user-defined tranches */
+		if (i >= LWTRANCHE_FIRST_USER_DEFINED &&
+			stats[i].acquire_count == 0 &&
+			stats[i].block_count == 0)
+			continue;
+
+		MemSet(nulls, 0, sizeof(nulls));
+
+		values[0] = Int32GetDatum(i);
+		values[1] = CStringGetTextDatum(GetLWLockIdentifier(PG_WAIT_LWLOCK, i));
+		values[2] = Int64GetDatum(stats[i].acquire_count);
+		values[3] = Int64GetDatum(stats[i].block_count);
+		/* convert microseconds to milliseconds, as for checkpoint timings */
+		values[4] = Float8GetDatum((double) stats[i].wait_time / 1000.0);
+		values[5] = Int64GetDatum(stats[i].spin_delay_count);
+
+		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+	}
+
+	pfree(stats);
+
+	/* clean up and return the tuplestore */
+	tuplestore_donestoring(tupstore);
+
+	return (Datum) 0;
+}
+
+/*
+ * Returns the buffer usage statistics of the SLRU caches, one row per SLRU.
+ */
+Datum
+pg_stat_get_slru(PG_FUNCTION_ARGS)
+{
+#define PG_STAT_GET_SLRU_COLS	6
+	TupleDesc	tupdesc;
+	Tuplestorestate *tupstore;
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	MemoryContext per_query_ctx;
+	MemoryContext oldcontext;
+	SlruCtl		ctl;
+	int			i;
+
+	/* check to see if caller supports us returning a tuplestore */
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("materialize mode required, but it is not " \
+						"allowed in this context")));
+
+	/* Build a tuple descriptor for our result type */
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+	MemoryContextSwitchTo(oldcontext);
+
+	for (i = 0; (ctl = SimpleLruGetRegistered(i)) != NULL; i++)
+	{
+		SlruShared	shared = ctl->shared;
+		Datum		values[PG_STAT_GET_SLRU_COLS];
+		bool		nulls[PG_STAT_GET_SLRU_COLS];
+
+		MemSet(nulls, 0, sizeof(nulls));
+
+		values[0] = CStringGetTextDatum(shared->lwlock_tranche_name);
+		values[1] = Int32GetDatum(shared->num_slots);
+		values[2] = Int64GetDatum(pg_atomic_read_u64(&shared->stat_blks_zeroed));
+		values[3] = Int64GetDatum(pg_atomic_read_u64(&shared->stat_blks_hit));
+		values[4] = Int64GetDatum(pg_atomic_read_u64(&shared->stat_blks_read));
+		values[5] = Int64GetDatum(pg_atomic_read_u64(&shared->stat_blks_written));
+
+		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+	}
+
+	/* clean up and return the tuplestore */
+	tuplestore_donestoring(tupstore);
+
+	return (Datum) 0;
+}
+
 /*
  * Returns activity of PG backends.
  */
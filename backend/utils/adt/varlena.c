@@ -3004,45 +3004,113 @@ bytea_overlay(bytea *t1, bytea *t2, int sp, int sl)
 	return result;
 }
 
+/*
+ * byteapos_search -
+ *	  Find the first occurrence of p2 in p1 that starts before limit.
+ *	  Returns its 0-based offset, or -1 if there is none.
+ */
+static int
+byteapos_search(const char *p1, int len1, const char *p2, int len2, int limit)
+{
+	int			px,
+				p;
+
+	px = Min(len1 - len2, limit - 1);
+	for (p = 0; p <= px; p++)
+	{
+		if ((p1[p] == *p2) && (memcmp(p1 + p, p2, len2) == 0))
+			return p;
+	}
+
+	return -1;
+}
+
 /*
  * byteapos -
  *	  Return the position of the specified substring.
  *	  Implements the SQL POSITION() function.
  * Cloned from textpos and modified as required.
+ *
+ * The haystack is read with a detoast iterator, so for a large value stored
+ * out of line we fetch toast chunks only until the first match, rather than
+ * the whole value.  We keep the last len2 - 1 bytes seen so that matches
+ * spanning a chunk boundary are found too.
  */
 Datum
 byteapos(PG_FUNCTION_ARGS)
 {
-	bytea	   *t1 = PG_GETARG_BYTEA_PP(0);
+	struct varlena *t1 = (struct varlena *) PG_GETARG_POINTER(0);
 	bytea	   *t2 = PG_GETARG_BYTEA_PP(1);
+	DetoastIterator iter;
+	const char *data;
+	int32		len;
 	int			pos;
-	int			px,
-				p;
-	int			len1,
-				len2;
-	char	   *p1,
-			   *p2;
+	int			consumed;
+	int			len2;
+	char	   *p2;
+	char	   *carry;
+	int			ncarry;
 
-	len1 = VARSIZE_ANY_EXHDR(t1);
 	len2 = VARSIZE_ANY_EXHDR(t2);
 
 	if (len2 <= 0)
 		PG_RETURN_INT32(1);		/* result for empty pattern */
 
-	p1 = VARDATA_ANY(t1);
 	p2 = VARDATA_ANY(t2);
 
+	/* room for the saved tail plus the head of the next piece */
+	carry = palloc(2 * (len2 - 1) + 1);
+	ncarry = 0;
+
 	pos = 0;
-	px = (len1 - len2);
-	for (p = 0; p <= px; p++)
+	consumed = 0;
+	iter = detoast_iterator_begin(t1);
+	while (detoast_iterator_next(iter, &data, &len))
 	{
-		if ((*p2 == *p1) && (memcmp(p1, p2, len2) == 0))
+		int			found;
+
+		/* first look for a match that starts in the saved tail */
+		if (ncarry > 0)
+		{
+			int			nhead = Min(len, len2 - 1);
+
+			memcpy(carry + ncarry, data, nhead);
+			found = byteapos_search(carry, ncarry + nhead, p2, len2, ncarry);
+			if (found >= 0)
+			{
+				pos = consumed - ncarry + found + 1;
+				break;
+			}
+		}
+
+		/* then for one that lies entirely within this piece */
+		found = byteapos_search(data, len, p2, len2, len);
+		if (found >= 0)
 		{
-			pos = p + 1;
+			pos = consumed + found + 1;
 			break;
-		};
-		p1++;
-	};
+		}
+
+		/* save the last len2 - 1 bytes seen so far */
+		if (len >= len2 - 1)
+		{
+			memcpy(carry, data + len - (len2 - 1), len2 - 1);
+			ncarry = len2 - 1;
+		}
+		else
+		{
+			int			keep = Min(len2 - 1, ncarry + len);
+
+			memcpy(carry + ncarry, data, len);
+			memmove(carry, carry + ncarry + len - keep, keep);
+			ncarry = keep;
+		}
+		consumed += len;
+	}
+	detoast_iterator_end(iter);
+
+	pfree(carry);
+	PG_FREE_IF_COPY(t2, 1);
 
 	PG_RETURN_INT32(pos);
 }
@@ -2344,6 +2344,7 @@ RelationDestroyRelation(Relation relation, bool remember_tupdesc)
 	list_free(relation->rd_statlist);
 	bms_free(relation->rd_indexattr);
 	bms_free(relation->rd_projindexattr);
+	bms_free(relation->rd_summarizedattr);
 	bms_free(relation->rd_keyattr);
 	bms_free(relation->rd_pkattr);
 	bms_free(relation->rd_idattr);
@@ -4987,6 +4988,7 @@ RelationGetIndexAttrBitmap(Relation relation, IndexAttrBitmapKind attrKind)
 {
 	Bitmapset  *indexattrs;		/* columns used in non-projection indexes */
 	Bitmapset  *projindexattrs; /* columns used in projection indexes */
+	Bitmapset  *summarizedattrs;	/* columns used in summarizing indexes */
 	Bitmapset  *uindexattrs;	/* columns in unique indexes */
 	Bitmapset  *pkindexattrs;	/* columns in the primary index */
 	Bitmapset  *idindexattrs;	/* columns in the replica identity */
@@ -5008,6 +5010,8 @@ RelationGetIndexAttrBitmap(Relation relation, IndexAttrBitmapKind attrKind)
 				return bms_copy(relation->rd_indexattr);
 			case INDEX_ATTR_BITMAP_PROJ:
 				return bms_copy(relation->rd_projindexattr);
+			case INDEX_ATTR_BITMAP_SUMMARIZED:
+				return bms_copy(relation->rd_summarizedattr);
 			case INDEX_ATTR_BITMAP_KEY:
 				return bms_copy(relation->rd_keyattr);
 			case INDEX_ATTR_BITMAP_PRIMARY_KEY:
@@ -5044,7 +5048,8 @@ restart:
 	relreplindex = relation->rd_replidindex;
 
 	/*
-	 * For each index, add referenced attributes to indexattrs.
+	 * For each index, add referenced attributes to indexattrs, or to
+	 * summarizedattrs if the index AM only keeps a summary of the heap.
 	 *
 	 * Note: we consider all indexes returned by RelationGetIndexList, even if
 	 * they are not indisready or indisvalid.  This is important because an
@@ -5055,6 +5060,7 @@ restart:
 	 */
 	indexattrs = NULL;
 	projindexattrs = NULL;
+	summarizedattrs = NULL;
 	uindexattrs = NULL;
 	pkindexattrs = NULL;
 	idindexattrs = NULL;
@@ -5072,9 +5078,21 @@ restart:
 		bool		isKey;		/* candidate key */
 		bool		isPK;		/* primary key */
 		bool		isIDKey;	/* replica identity index */
+		Bitmapset **attrs;
 
 		indexDesc = index_open(indexOid, AccessShareLock);
 
+		/*
+		 * Summarizing indexes do not point at individual tuples, so changes
+		 * to the columns they cover need not prevent a HOT update; the
+		 * caller just has to insert into them afterwards.  Keep their
+		 * columns separate so heap_update can tell the two cases apart.
+		 */
+		if (indexDesc->rd_amroutine->amsummarizing)
+			attrs = &summarizedattrs;
+		else
+			attrs = &indexattrs;
+
 		/*
 		 * Extract index expressions and index predicate.  Note: Don't use
 		 * RelationGetIndexExpressions()/RelationGetIndexPredicate(), because
@@ -5124,8 +5142,8 @@ restart:
 			 */
 			if (attrnum != 0)
 			{
-				indexattrs = bms_add_member(indexattrs,
-											attrnum - FirstLowInvalidHeapAttributeNumber);
+				*attrs = bms_add_member(*attrs,
+										attrnum - FirstLowInvalidHeapAttributeNumber);
 
 				if (isKey && i < indexDesc->rd_index->indnkeyatts)
 					uindexattrs = bms_add_member(uindexattrs,
@@ -5142,7 +5160,8 @@ restart:
 		}
 
 		/* Collect attributes used in expressions, too */
-		if (IsProjectionFunctionalIndex(indexDesc))
+		if (!indexDesc->rd_amroutine->amsummarizing &&
+			IsProjectionFunctionalIndex(indexDesc))
 		{
 			projindexes = bms_add_member(projindexes, indexno);
 			pull_varattnos(indexExpressions, 1, &projindexattrs);
@@ -5150,10 +5169,10 @@ restart:
 		else
 		{
 			/* Collect all attributes used in expressions, too */
-			pull_varattnos(indexExpressions, 1, &indexattrs);
+			pull_varattnos(indexExpressions, 1, attrs);
 		}
 		/* Collect all attributes in the index predicate, too */
-		pull_varattnos(indexPredicate, 1, &indexattrs);
+		pull_varattnos(indexPredicate, 1, attrs);
 
 		index_close(indexDesc, AccessShareLock);
 		indexno += 1;
@@ -5184,6 +5203,7 @@ restart:
 		bms_free(idindexattrs);
 		bms_free(indexattrs);
 		bms_free(projindexattrs);
+		bms_free(summarizedattrs);
 		bms_free(projindexes);
 
 		goto restart;
@@ -5194,6 +5214,8 @@ restart:
 	relation->rd_indexattr = NULL;
 	bms_free(relation->rd_projindexattr);
 	relation->rd_projindexattr = NULL;
+	bms_free(relation->rd_summarizedattr);
+	relation->rd_summarizedattr = NULL;
 	bms_free(relation->rd_keyattr);
 	relation->rd_keyattr = NULL;
 	bms_free(relation->rd_pkattr);
@@ -5216,6 +5238,7 @@ restart:
 	relation->rd_idattr = bms_copy(idindexattrs);
 	relation->rd_indexattr = bms_copy(indexattrs);
 	relation->rd_projindexattr = bms_copy(projindexattrs);
+	relation->rd_summarizedattr = bms_copy(summarizedattrs);
 	relation->rd_projidx = bms_copy(projindexes);
 	MemoryContextSwitchTo(oldcxt);
 
@@ -5226,6 +5249,8 @@ restart:
 			return indexattrs;
 		case INDEX_ATTR_BITMAP_PROJ:
 			return projindexattrs;
+		case INDEX_ATTR_BITMAP_SUMMARIZED:
+			return summarizedattrs;
 		case INDEX_ATTR_BITMAP_KEY:
 			return uindexattrs;
 		case INDEX_ATTR_BITMAP_PRIMARY_KEY:
@@ -5866,6 +5891,7 @@ load_relcache_init_file(bool shared)
 		rel->rd_replidindex = InvalidOid;
 		rel->rd_indexattr = NULL;
 		rel->rd_projindexattr = NULL;
+		rel->rd_summarizedattr = NULL;
 		rel->rd_keyattr = NULL;
 		rel->rd_pkattr = NULL;
 		rel->rd_idattr = NULL;
@@ -1461,6 +1461,51 @@ HeapTupleIsSurelyDead(HeapTuple htup, TransactionId OldestXmin)
 	return TransactionIdPrecedes(HeapTupleHeaderGetRawXmax(tuple), OldestXmin);
 }
 
+/*
+ * Snapshots with more XIDs than this are sorted the first time they are
+ * searched, so that XidInMVCCSnapshot can use binary search.  Below this a
+ * linear scan of the array is as fast, and saves the cost of sorting
+ * snapshots that are only consulted a handful of times.
+ */
+#define XID_ARRAY_SORT_THRESHOLD	32
+
+/*
+ * Sort the XID arrays of a snapshot in place.  Only membership matters for
+ * visibility, so reordering the arrays doesn't change the snapshot.
+ */
+static void
+SortSnapshotXids(Snapshot snapshot)
+{
+	if (snapshot->xcnt > 1)
+		qsort(snapshot->xip, snapshot->xcnt, sizeof(TransactionId),
+			  xidComparator);
+	if (snapshot->subxcnt > 1)
+		qsort(snapshot->subxip, snapshot->subxcnt, sizeof(TransactionId),
+			  xidComparator);
+	snapshot->xidsSorted = true;
+}
+
+/*
+ * Search for xid in one of the XID arrays of a snapshot.
+ */
+static inline bool
+XidInSnapshotArray(TransactionId xid, TransactionId *xids, uint32 nxids,
+				   bool sorted)
+{
+	uint32		i;
+
+	if (sorted)
+		return bsearch(&xid, xids, nxids, sizeof(TransactionId),
+					   xidComparator) != NULL;
+
+	for (i = 0; i < nxids; i++)
+	{
+		if (TransactionIdEquals(xid, xids[i]))
+			return true;
+	}
+	return false;
+}
+
 /*
  * XidInMVCCSnapshot
  *		Is the given XID still-in-progress according to the snapshot?
@@ -1474,8 +1519,6 @@ HeapTupleIsSurelyDead(HeapTuple htup, TransactionId OldestXmin)
 bool
 XidInMVCCSnapshot(TransactionId xid, Snapshot snapshot)
 {
-	uint32		i;
-
 	/*
 	 * Make a quick range check to eliminate most XIDs without looking at the
 	 * xip arrays.  Note that this is OK even if we convert a subxact XID to
@@ -1491,6 +1534,11 @@ XidInMVCCSnapshot(TransactionId xid, Snapshot snapshot)
 	if (TransactionIdFollowsOrEquals(xid, snapshot->xmax))
 		return true;
 
+	/* Large arrays are worth sorting once, to allow binary search */
+	if (!snapshot->xidsSorted &&
+		snapshot->xcnt + (uint32) snapshot->subxcnt > XID_ARRAY_SORT_THRESHOLD)
+		SortSnapshotXids(snapshot);
+
 	/*
 	 * Snapshot information is stored slightly differently in snapshots taken
 	 * during recovery.
@@ -1507,13 +1555,9 @@ XidInMVCCSnapshot(TransactionId xid, Snapshot snapshot)
 		if (!snapshot->suboverflowed)
 		{
 			/* we have full data, so search subxip */
-			int32		j;
-
-			for (j = 0; j < snapshot->subxcnt; j++)
-			{
-				if (TransactionIdEquals(xid, snapshot->subxip[j]))
-					return true;
-			}
+			if (XidInSnapshotArray(xid, snapshot->subxip, snapshot->subxcnt,
+								   snapshot->xidsSorted))
+				return true;
 
 			/* not there, fall through to search xip[] */
 		}
@@ -1534,16 +1578,12 @@ XidInMVCCSnapshot(TransactionId xid, Snapshot snapshot)
 				return false;
 		}
 
-		for (i = 0; i < snapshot->xcnt; i++)
-		{
-			if (TransactionIdEquals(xid, snapshot->xip[i]))
-				return true;
-		}
+		if (XidInSnapshotArray(xid, snapshot->xip, snapshot->xcnt,
+							   snapshot->xidsSorted))
+			return true;
 	}
 	else
 	{
-		int32		j;
-
 		/*
 		 * In recovery we store all xids in the subxact array because it is by
 		 * far the bigger array, and we mostly don't know which xids are
@@ -1573,11 +1613,9 @@ XidInMVCCSnapshot(TransactionId xid, Snapshot snapshot)
 		 * indeterminate xid. We don't know whether it's top level or subxact
 		 * but it doesn't matter. If it's present, the xid is visible.
 		 */
-		for (j = 0; j < snapshot->subxcnt; j++)
-		{
-			if (TransactionIdEquals(xid, snapshot->subxip[j]))
-				return true;
-		}
+		if (XidInSnapshotArray(xid, snapshot->subxip, snapshot->subxcnt,
+							   snapshot->xidsSorted))
+			return true;
 	}
 
 	return false;
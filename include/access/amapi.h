@@ -194,6 +194,8 @@ typedef struct IndexAmRoutine
 	bool		amcanparallel;
 	/* does AM support columns included with clause INCLUDE? */
 	bool		amcaninclude;
+	/* does AM store only a summary of each block range, not heap TIDs? */
+	bool		amsummarizing;
 	/* type of data stored in index, or InvalidOid if variable */
 	Oid			amkeytype;
 
@@ -585,6 +585,13 @@ do { \
 #define MaxHeapTupleSize  (BLCKSZ - MAXALIGN(SizeOfPageHeaderData + sizeof(ItemIdData)))
 #define MinHeapTupleSize  MAXALIGN(SizeofHeapTupleHeader)
 
+/*
+ * HeapPageEmptyFreeSpace is what PageGetHeapFreeSpace() reports for a heap
+ * page that has just been initialized.  It's recorded in the FSM for pages
+ * that were added as zeroes and have not been initialized yet.
+ */
+#define HeapPageEmptyFreeSpace	(BLCKSZ - SizeOfPageHeaderData - sizeof(ItemIdData))
+
 /*
  * MaxHeapTuplesPerPage is an upper bound on the number of tuples that can
  * fit on one heap page.  (Note that indexes could have more, because they
@@ -29,8 +29,8 @@
 #define MaxMultiXactOffset	((MultiXactOffset) 0xFFFFFFFF)
 
 /* Number of SLRU buffers to use for multixact */
-#define NUM_MXACTOFFSET_BUFFERS		8
-#define NUM_MXACTMEMBER_BUFFERS		16
+extern PGDLLIMPORT int multixact_offset_buffers;
+extern PGDLLIMPORT int multixact_member_buffers;
 
 /*
  * Possible multixact lock modes ("status").  The first four modes are for
@@ -14,6 +14,7 @@
 #define SLRU_H
 
 #include "access/xlogdefs.h"
+#include "port/atomics.h"
 #include "storage/lwlock.h"
 
 
@@ -35,6 +36,17 @@
 /* Maximum length of an SLRU name */
 #define SLRU_MAX_NAME_LENGTH	32
 
+/*
+ * Buffer slots are grouped into banks of about SLRU_BANK_SIZE slots, and a
+ * given page can only ever be cached in one bank, chosen by its page number.
+ * Looking up a page or choosing a victim to evict thus only has to scan one
+ * bank instead of all the slots, which keeps large SLRU caches cheap.
+ */
+#define SLRU_BANK_SIZE			16
+
+/* Upper limit for the *_buffers settings of the individual SLRUs (1GB) */
+#define SLRU_MAX_ALLOWED_BUFFERS	((1024 * 1024 * 1024) / BLCKSZ)
+
 /*
  * Page status codes.  Note that these do not include the "dirty" bit.
  * page_dirty can be true only in the VALID or WRITE_IN_PROGRESS states;
@@ -59,6 +71,9 @@ typedef struct SlruSharedData
 	/* Number of buffers managed by this SLRU structure */
 	int			num_slots;
 
+	/* Number of banks the buffers are divided into, see SLRU_BANK_SIZE */
+	int			num_banks;
+
 	/*
 	 * Arrays holding info for each buffer slot.  Page number is undefined
 	 * when status is EMPTY, as is page_lru_count.
@@ -102,6 +117,16 @@ typedef struct SlruSharedData
 	int			lwlock_tranche_id;
 	char		lwlock_tranche_name[SLRU_MAX_NAME_LENGTH];
 	LWLockPadded *buffer_locks;
+
+	/*
+	 * Cumulative statistics, reported by the pg_stat_slru view.  These are
+	 * updated without holding the control lock exclusively, hence atomics.
+	 * Hits are counted locally first, see SimpleLruReportStats.
+	 */
+	pg_atomic_uint64 stat_blks_zeroed;	/* pages initialized to zeroes */
+	pg_atomic_uint64 stat_blks_hit; /* lookups satisfied from a buffer */
+	pg_atomic_uint64 stat_blks_read;	/* pages read from disk */
+	pg_atomic_uint64 stat_blks_written; /* pages written to disk */
 } SlruSharedData;
 
 typedef SlruSharedData *SlruShared;
@@ -120,6 +145,9 @@ typedef struct SlruCtlData
 	 */
 	bool		do_fsync;
 
+	/* Hits not yet added to shared->stat_blks_hit by this process */
+	uint64		pending_blks_hit;
+
 	/*
 	 * Decide whether a page is "older" for truncation and as a hint for
 	 * evicting pages in LRU order.  Return true if every entry of the first
@@ -159,6 +187,8 @@ extern void SlruPagePrecedesUnitTests(SlruCtl ctl, int per_page);
 #endif
 extern void SimpleLruTruncate(SlruCtl ctl, int cutoffPage);
 extern bool SimpleLruDoesPhysicalPageExist(SlruCtl ctl, int pageno);
+extern SlruCtl SimpleLruGetRegistered(int n);
+extern void SimpleLruReportStats(void);
 
 typedef bool (*SlruScanCallback) (SlruCtl ctl, char *filename, int segpage,
 								  void *data);
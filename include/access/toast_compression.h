@@ -0,0 +1,89 @@
+/*-------------------------------------------------------------------------
+ *
+ * toast_compression.h
+ *	  Functions for toast compression.
+ *
+ * Copyright (c) 2000-2018, PostgreSQL Global Development Group
+ *
+ * src/include/access/toast_compression.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef TOAST_COMPRESSION_H
+#define TOAST_COMPRESSION_H
+
+/*
+ * Built-in compression methods.  The method ID is stored in the two high
+ * bits of the raw size word of every compressed varlena (see postgres.h), so
+ * these values are on-disk data and must never change.  pglz has to be zero
+ * so that datums written before compression methods existed still read back
+ * as pglz.
+ */
+typedef enum ToastCompressionId
+{
+	TOAST_PGLZ_COMPRESSION_ID = 0,
+	TOAST_LZ4_COMPRESSION_ID = 1,
+	TOAST_ZSTD_COMPRESSION_ID = 2,
+	TOAST_INVALID_COMPRESSION_ID = 3
+} ToastCompressionId;
+
+/*
+ *	The information at the start of the compressed toast data.
+ */
+typedef struct toast_compress_header
+{
+	int32		vl_len_;		/* varlena header (do not touch directly!) */
+	uint32		tcinfo;			/* 2 bits for compression method and 30 bits
+								 * for the raw size */
+} toast_compress_header;
+
+/*
+ * Utilities for manipulation of header information for compressed
+ * toast entries.
+ */
+#define TOAST_COMPRESS_HDRSZ		((int32) sizeof(toast_compress_header))
+#define TOAST_COMPRESS_RAWSIZE(ptr) \
+	((int32) (((toast_compress_header *) (ptr))->tcinfo & VARLENA_RAWSIZE_MASK))
+#define TOAST_COMPRESS_METHOD(ptr) \
+	((ToastCompressionId) (((toast_compress_header *) (ptr))->tcinfo >> \
+						   VARLENA_RAWSIZE_BITS))
+#define TOAST_COMPRESS_RAWDATA(ptr) \
+	(((char *) (ptr)) + TOAST_COMPRESS_HDRSZ)
+#define TOAST_COMPRESS_SET_SIZE_AND_METHOD(ptr, len, cm_method) \
+	do { \
+		Assert((len) > 0 && (len) <= VARLENA_RAWSIZE_MASK); \
+		Assert((cm_method) >= TOAST_PGLZ_COMPRESSION_ID && \
+			   (cm_method) < TOAST_INVALID_COMPRESSION_ID); \
+		((toast_compress_header *) (ptr))->tcinfo = \
+			((uint32) (len)) | ((uint32) (cm_method) << VARLENA_RAWSIZE_BITS); \
+	} while (0)
+
+/* GUC */
+extern int	default_toast_compression;
+
+/* pglz compression/decompression routines */
+extern struct varlena *pglz_compress_datum(const struct varlena *value);
+extern struct varlena *pglz_decompress_datum(const struct varlena *value);
+extern struct varlena *pglz_decompress_datum_slice(const struct varlena *value,
+							int32 slicelength);
+extern int32 pglz_maximum_compressed_size(int32 rawsize,
+							 int32 total_compressed_size);
+
+/* lz4 compression/decompression routines */
+extern struct varlena *lz4_compress_datum(const struct varlena *value);
+extern struct varlena *lz4_decompress_datum(const struct varlena *value);
+extern struct varlena *lz4_decompress_datum_slice(const struct varlena *value,
+						   int32 slicelength);
+
+/* zstd compression/decompression routines */
+extern struct varlena *zstd_compress_datum(const struct varlena *value);
+extern struct varlena *zstd_decompress_datum(const struct varlena *value);
+extern struct varlena *zstd_decompress_datum_slice(const struct varlena *value,
+							int32 slicelength);
+
+/* other stuff */
+extern ToastCompressionId GetToastCompressionId(const char *name);
+extern const char *GetToastCompressionName(ToastCompressionId cmid);
+extern void validateToastCompressionOption(const char *value);
+
+#endif							/* TOAST_COMPRESSION_H */
@@ -135,6 +135,14 @@ typedef struct VariableCacheData
 	TransactionId latestCompletedXid;	/* newest XID that has committed or
 										 * aborted */
 
+	/*
+	 * Number of top-level transactions with XIDs completed since startup;
+	 * also bumped whenever the set of running XIDs visible to snapshots may
+	 * otherwise have changed.  GetSnapshotData() uses it to tell whether a
+	 * previously computed snapshot can be reused as-is.
+	 */
+	uint64		xactCompletionCount;
+
 	/*
 	 * These fields are protected by CLogTruncationLock
 	 */
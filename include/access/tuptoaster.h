@@ -174,6 +174,25 @@ extern struct varlena *heap_tuple_untoast_attr_slice(struct varlena *attr,
 							  int32 sliceoffset,
 							  int32 slicelength);
 
+/* ----------
+ * detoast_iterator_begin() -
+ * detoast_iterator_next() -
+ * detoast_iterator_end() -
+ *
+ *		Consume a possibly-toasted attribute piece by piece, in order.
+ *		An uncompressed external value is read one toast chunk at a
+ *		time, so it never has to be materialized as a whole.  Any other
+ *		value is detoasted up front and returned as a single piece.
+ *		A piece stays valid only until the next call.
+ * ----------
+ */
+typedef struct DetoastIteratorData *DetoastIterator;
+
+extern DetoastIterator detoast_iterator_begin(struct varlena *attr);
+extern bool detoast_iterator_next(DetoastIterator iter,
+					  const char **data, int32 *len);
+extern void detoast_iterator_end(DetoastIterator iter);
+
 /* ----------
  * toast_flatten_tuple -
  *
@@ -207,10 +226,11 @@ extern HeapTuple toast_build_flattened_tuple(TupleDesc tupleDesc,
 /* ----------
  * toast_compress_datum -
  *
- *	Create a compressed version of a varlena datum, if possible
+ *	Create a compressed version of a varlena datum, if possible, using
+ *	the given ToastCompressionId
  * ----------
  */
-extern Datum toast_compress_datum(Datum value);
+extern Datum toast_compress_datum(Datum value, int cmethod);
 
 /* ----------
  * toast_raw_datum_size -
@@ -99,19 +99,29 @@ extern int	min_wal_size_mb;
 extern int	max_wal_size_mb;
 extern int	wal_keep_segments;
 extern int	XLOGbuffers;
+extern int	NumXLogInsertLocks;
 extern int	XLogArchiveTimeout;
 extern int	wal_retrieve_retry_interval;
 extern char *XLogArchiveCommand;
 extern bool EnableHotStandby;
 extern bool fullPageWrites;
 extern bool wal_log_hints;
-extern bool wal_compression;
+extern int	wal_compression;
+extern int	wal_record_compression;
 extern bool *wal_consistency_checking;
 extern char *wal_consistency_checking_string;
 extern bool log_checkpoints;
 
 extern int	CheckPointSegments;
 
+/*
+ * Default and maximum number of WAL insertion locks.  Acquiring all of them
+ * must stay well below the number of LWLocks a backend can hold at once
+ * (MAX_SIMUL_LWLOCKS in lwlock.c).
+ */
+#define DEFAULT_XLOGINSERT_LOCKS	8
+#define MAX_XLOGINSERT_LOCKS		128
+
 /* Archive modes */
 typedef enum ArchiveMode
 {
@@ -121,6 +131,15 @@ typedef enum ArchiveMode
 } ArchiveMode;
 extern int	XLogArchiveMode;
 
+/* Compression methods for wal_compression and wal_record_compression */
+typedef enum WalCompression
+{
+	WAL_COMPRESSION_NONE = 0,
+	WAL_COMPRESSION_PGLZ,
+	WAL_COMPRESSION_LZ4,
+	WAL_COMPRESSION_ZSTD
+} WalCompression;
+
 /* WAL levels */
 typedef enum WalLevel
 {
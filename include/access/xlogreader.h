@@ -133,6 +133,10 @@ struct XLogReaderState
 	uint32		main_data_len;	/* main data portion's length */
 	uint32		main_data_bufsz;	/* allocated size of the buffer */
 
+	/* buffer for the decompressed payload of a compressed record */
+	char	   *decompressed_data;
+	uint32		decompressed_bufsz; /* allocated size of the buffer */
+
 	RepOriginId record_origin;
 
 	/* information about blocks referenced by the record. */
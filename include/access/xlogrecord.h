@@ -20,6 +20,7 @@
 /*
  * The overall layout of an XLOG record is:
  *		Fixed-size header (XLogRecord struct)
+ *		XLogRecordCompressHeader struct (optional)
  *		XLogRecordBlockHeader struct
  *		XLogRecordBlockHeader struct
  *		...
@@ -37,6 +38,10 @@
  * The XLogRecordBlockHeader, XLogRecordDataHeaderShort and
  * XLogRecordDataHeaderLong structs all begin with a single 'id' byte. It's
  * used to distinguish between block references, and the main data structs.
+ *
+ * If the record begins with an XLogRecordCompressHeader, everything after
+ * the headers (the block data and main data) is stored compressed, see
+ * below.
  */
 typedef struct XLogRecord
 {
@@ -115,7 +120,8 @@ typedef struct XLogRecordBlockHeader
  * present is BLCKSZ - the length of "hole" bytes.
  *
  * When wal_compression is enabled, a full page image which "hole" was
- * removed is additionally compressed using PGLZ compression algorithm.
+ * removed is additionally compressed using the configured compression
+ * method (PGLZ, LZ4 or ZSTD).
  * This can reduce the WAL volume, but at some extra cost of CPU spent
  * on the compression during WAL logging. In this case, since the "hole"
  * length cannot be calculated by subtracting the number of page image bytes
@@ -149,6 +155,13 @@ typedef struct XLogRecordBlockImageHeader
 #define BKPIMAGE_APPLY		0x04	/* page image should be restored during
 									 * replay */
 
+/*
+ * Compression method of a compressed page image.  Images with
+ * BKPIMAGE_IS_COMPRESSED set but neither of these are compressed with PGLZ.
+ */
+#define BKPIMAGE_COMPRESS_LZ4	0x08
+#define BKPIMAGE_COMPRESS_ZSTD	0x10
+
 /*
  * Extra header information used when page image has "hole" and
  * is compressed.
@@ -208,6 +221,30 @@ typedef struct XLogRecordDataHeaderLong
 
 #define SizeOfXLogRecordDataHeaderLong (sizeof(uint8) + sizeof(uint32))
 
+/*
+ * XLogRecordCompressHeader is present, directly after the fixed-size
+ * XLogRecord header, when the payload of the record has been compressed as
+ * a whole (wal_record_compression).  The lengths in the block and main data
+ * headers that follow it refer to the uncompressed payload; 'length' is the
+ * number of compressed bytes actually stored after the headers.
+ *
+ * (This struct is currently not used in the code, it is here just for
+ * documentation purposes).
+ */
+typedef struct XLogRecordCompressHeader
+{
+	uint8		id;				/* XLR_BLOCK_ID_COMPRESSED */
+	uint8		method;			/* XLR_COMPRESS_* */
+	/* followed by uint32 length, unaligned */
+}			XLogRecordCompressHeader;
+
+#define SizeOfXLogRecordCompressHeader (sizeof(uint8) * 2 + sizeof(uint32))
+
+/* Compression methods for XLogRecordCompressHeader */
+#define XLR_COMPRESS_PGLZ			1
+#define XLR_COMPRESS_LZ4			2
+#define XLR_COMPRESS_ZSTD			3
+
 /*
  * Block IDs used to distinguish different kinds of record fragments. Block
  * references are numbered from 0 to XLR_MAX_BLOCK_ID. A rmgr is free to use
@@ -224,5 +261,6 @@ typedef struct XLogRecordDataHeaderLong
 #define XLR_BLOCK_ID_DATA_SHORT		255
 #define XLR_BLOCK_ID_DATA_LONG		254
 #define XLR_BLOCK_ID_ORIGIN			253
+#define XLR_BLOCK_ID_COMPRESSED		252
 
 #endif							/* XLOGRECORD_H */
@@ -20,7 +20,7 @@
 /*
  * The number of SLRU page buffers we use for the notification queue.
  */
-#define NUM_ASYNC_BUFFERS	8
+extern PGDLLIMPORT int notify_buffers;
 
 extern bool Trace_notify;
 extern volatile sig_atomic_t notifyInterruptPending;
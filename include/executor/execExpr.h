@@ -70,6 +70,11 @@ typedef enum ExprEvalOp
 	EEOP_OUTER_VAR,
 	EEOP_SCAN_VAR,
 
+	/* ditto, detoasted through the slot's per-tuple detoast cache */
+	EEOP_INNER_VAR_DETOAST,
+	EEOP_OUTER_VAR_DETOAST,
+	EEOP_SCAN_VAR_DETOAST,
+
 	/* compute system Var value */
 	EEOP_INNER_SYSVAR,
 	EEOP_OUTER_SYSVAR,
@@ -279,7 +284,7 @@ typedef struct ExprEvalStep
 			TupleDesc	known_desc;
 		}			fetch;
 
-		/* for EEOP_INNER/OUTER/SCAN_[SYS]VAR[_FIRST] */
+		/* for EEOP_INNER/OUTER/SCAN_[SYS]VAR[_FIRST], and _VAR_DETOAST */
 		struct
 		{
 			/* attnum is attr number - 1 for regular VAR ... */
@@ -748,6 +753,8 @@ extern void ExecEvalAlternativeSubPlan(ExprState *state, ExprEvalStep *op,
 						   ExprContext *econtext);
 extern void ExecEvalWholeRowVar(ExprState *state, ExprEvalStep *op,
 					ExprContext *econtext);
+extern void ExecEvalVarDetoast(ExprState *state, ExprEvalStep *op,
+				   ExprContext *econtext);
 
 extern void ExecAggInitGroup(AggState *aggstate, AggStatePerTrans pertrans, AggStatePerGroup pergroup);
 extern Datum ExecAggTransReparent(AggState *aggstate, AggStatePerTrans pertrans,
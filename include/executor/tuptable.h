@@ -162,6 +162,12 @@
  * tts_slow/tts_off are saved state for slot_deform_tuple, and should not
  * be touched by any other code.
  *
+ * tts_detoasted caches detoasted versions of toasted tts_values entries, so
+ * that a value used by several expressions is fetched and decompressed only
+ * once per tuple (see ExecFetchSlotDetoastedAttr).  The cached values live
+ * in tts_detoastcxt and are discarded whenever the slot's contents change;
+ * tts_values itself is never modified.
+ *
  * tts_slow/tts_off为slot_deform_tuple保存了状态，不应被其它代码访问。
  * 元组表存储在EState的es_tupleTable字段中。节点会根据自身需求申请分配TupleTableSlot，
  * 用于存储节点的输出元组、扫描到的元组等。执行完成后会统一释放元组表中的所有元组。执行器定义
@@ -203,6 +209,9 @@ typedef struct TupleTableSlot
 #define FIELDNO_TUPLETABLESLOT_OFF 14
 	uint32		tts_off;		/* saved state for slot_deform_tuple */
 	bool		tts_fixedTupleDescriptor;	/* descriptor can't be changed */
+	Datum	   *tts_detoasted;	/* detoasted copies of tts_values, or NULL */
+	MemoryContext tts_detoastcxt;	/* holds the detoasted values, or NULL */
+	bool		tts_detoastdirty;	/* any tts_detoasted entries set? */
 } TupleTableSlot;
 
 #define TTS_HAS_PHYSICAL_TUPLE(slot)  \
@@ -240,6 +249,7 @@ extern Datum ExecFetchSlotTupleDatum(TupleTableSlot *slot);
 extern HeapTuple ExecMaterializeSlot(TupleTableSlot *slot);
 extern TupleTableSlot *ExecCopySlot(TupleTableSlot *dstslot,
 			 TupleTableSlot *srcslot);
+extern Datum ExecFetchSlotDetoastedAttr(TupleTableSlot *slot, int attnum);
 
 /* in access/common/heaptuple.c */
 extern Datum slot_getattr(TupleTableSlot *slot, int attnum, bool *isnull);
@@ -978,6 +978,17 @@ typedef struct PlanState
 	 * descriptor, without encoding knowledge about all executor nodes.
 	 */
 	TupleDesc	scandesc;
+
+	/*
+	 * Attribute numbers of the inner, outer and scan tuple columns that the
+	 * node's qual and targetlist pass to more than one function.  Those
+	 * arguments are detoasted once per tuple; see execExpr.c.  Computed when
+	 * first needed, as flagged by ps_DetoastValid.
+	 */
+	bool		ps_DetoastValid;
+	Bitmapset  *ps_DetoastInner;
+	Bitmapset  *ps_DetoastOuter;
+	Bitmapset  *ps_DetoastScan;
 } PlanState;
 
 /* ----------------
@@ -159,6 +159,13 @@ typedef struct buftag
  * lock the buffer header; this is generally for situations where we don't
  * expect the flag bit being tested to be changing.
  *
+ * first_dirty_lsn is the WAL insert position at the time the buffer last
+ * went from clean to dirty.  Any change to the page since it was last
+ * written is therefore WAL-logged at or after that position.  It is set
+ * without the buffer header lock right after BM_DIRTY, so a reader holding
+ * the header lock may see the value from an earlier dirty period, which is
+ * never later than the true one.  It is meaningless when BM_DIRTY is unset.
+ *
  * We can't physically remove items from a disk page if another backend has
  * the buffer pinned.  Hence, a backend may need to wait for all other pins
  * to go away.  This is signaled by storing its own PID into
@@ -193,6 +200,8 @@ typedef struct BufferDesc
 	int			wait_backend_pid;	/* backend PID of pin-count waiter 等待钉页计数的后端进程PID，目前只能有一个 */
 	int			freeNext;		/* link in freelist chain  空闲链表中的链接 */
 
+	XLogRecPtr	first_dirty_lsn;	/* insert position when last dirtied */
+
 	LWLock		content_lock;	/* to lock access to buffer contents  访问缓冲区内容的锁 */
 } BufferDesc;
 
@@ -325,6 +334,9 @@ extern bool StrategyRejectBuffer(BufferAccessStrategy strategy,
 					 BufferDesc *buf);
 
 extern int	StrategySyncStart(uint32 *complete_passes, uint32 *num_buf_alloc);
+extern void StrategyRememberEviction(BufferTag *tag, uint32 hashcode);
+extern uint32 StrategyInitialUsageCount(BufferAccessStrategy strategy,
+						  BufferTag *tag, uint32 hashcode);
 extern void StrategyNotifyBgWriter(int bgwprocno);
 
 extern Size StrategyShmemSize(void);
@@ -336,6 +348,7 @@ extern Size BufTableShmemSize(int size);
 extern void InitBufTable(int size);
 extern uint32 BufTableHashCode(BufferTag *tagPtr);
 extern int	BufTableLookup(BufferTag *tagPtr, uint32 hashcode);
+extern int	BufTableLookupHint(uint32 hashcode);
 extern int	BufTableInsert(BufferTag *tagPtr, uint32 hashcode, int buf_id);
 extern void BufTableDelete(BufferTag *tagPtr, uint32 hashcode);
 
@@ -160,6 +160,26 @@ extern Size LWLockShmemSize(void);
 extern void CreateLWLocks(void);
 extern void InitLWLockAccess(void);
 
+/*
+ * Cumulative per-tranche wait statistics.  Each backend counts into its own
+ * slot in shared memory, so no atomics are needed; readers add up all the
+ * slots.  Tranches with an ID of LWLOCK_STATS_NUM_TRANCHES or more are not
+ * tracked.
+ */
+typedef struct LWLockTrancheStats
+{
+	uint64		acquire_count;	/* successful acquisitions */
+	uint64		block_count;	/* times we had to sleep on the lock */
+	uint64		wait_time;		/* time spent sleeping, in microseconds */
+	uint64		spin_delay_count;	/* spin delays on the wait list mutex */
+} LWLockTrancheStats;
+
+#define LWLOCK_STATS_NUM_TRANCHES	(LWTRANCHE_FIRST_USER_DEFINED + 64)
+
+extern Size LWLockStatsShmemSize(void);
+extern void LWLockStatsShmemInit(void);
+extern void LWLockCollectTrancheStats(LWLockTrancheStats *result);
+
 extern const char *GetLWLockIdentifier(uint32 classId, uint16 eventId);
 
 /*
@@ -28,7 +28,7 @@ extern int	max_predicate_locks_per_page;
 
 
 /* Number of SLRU buffers to use for predicate locking */
-#define NUM_OLDSERXID_BUFFERS	16
+extern PGDLLIMPORT int serializable_buffers;
 
 
 /*
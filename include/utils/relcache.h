@@ -56,6 +56,7 @@ typedef enum IndexAttrBitmapKind
 {
 	INDEX_ATTR_BITMAP_HOT,
 	INDEX_ATTR_BITMAP_PROJ,
+	INDEX_ATTR_BITMAP_SUMMARIZED,
 	INDEX_ATTR_BITMAP_KEY,
 	INDEX_ATTR_BITMAP_PRIMARY_KEY,
 	INDEX_ATTR_BITMAP_IDENTITY_KEY
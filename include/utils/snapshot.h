@@ -92,6 +92,7 @@ typedef struct SnapshotData
 	TransactionId *subxip;
 	int32		subxcnt;		/* # of xact ids in subxip[] */
 	bool		suboverflowed;	/* has the subxip array overflowed? */
+	bool		xidsSorted;		/* are xip[] and subxip[] sorted? */
 
 	bool		takenDuringRecovery;	/* recovery-shaped snapshot? */
 	bool		copied;			/* false if it's a static snapshot */
@@ -113,6 +114,13 @@ typedef struct SnapshotData
 
 	TimestampTz whenTaken;		/* timestamp when snapshot was taken */
 	XLogRecPtr	lsn;			/* position in the WAL stream when taken */
+
+	/*
+	 * The transaction completion count at the time GetSnapshotData() built
+	 * this snapshot.  Used to avoid recomputing static snapshots when
+	 * possible; zero means "don't reuse".
+	 */
+	uint64		snapXactCompletionCount;
 } SnapshotData;
 
 /*